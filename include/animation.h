@@ -5,8 +5,13 @@
 #include "sprite.h"
 #include "evhndlr.h"
 
-/* basic timer-based animation */
+class anim_scheduler;
+
+/* basic frame-based animation, advanced by anim_scheduler
+   once per frame from GM_UpdateFrame */
 class anim {
+  friend class anim_scheduler;
+
 public:
 
   // animation event details
@@ -33,6 +38,11 @@ public:
   // create empty animation
   anim();
 
+  // copies are created stopped
+  anim(const anim & other);
+  anim & operator=(const anim & other);
+  ~anim();
+
   // create new animation
   anim(const sprites_sheet * sheet,
        const anim_mode mode,
@@ -72,7 +82,7 @@ public:
   const unsigned int frame_duration() const { return _frame_duration; }
 
   // check animation status
-  bool is_running() const { return _timer != 0; }
+  bool is_running() const { return _slot >= 0; }
 
   // get animation size
   int width() const { return _sheet->sprite_width(); }
@@ -83,16 +93,21 @@ public:
   void stop(bool reset_current = true);
 
   // set current frame index
-  void set_current(int idx) { _current = idx; }
+  void set_current(int idx);
 
   // total number of animation frames for a sprites sheet
   int total_frames() const { return _sheet->rows() * _sheet->cols(); }
   
   // get current frame
-  int current() const { return _current; }
-
-  // get sprite corresponding to current frame
-  sprite current_sprite() const { return sprite(_current, width(), height(), _sheet); }
+  int current() const;
+
+  // get sprite corresponding to current frame, the scheduler one while running
+  sprite current_sprite() const
+  {
+    int idx = current();
+    const sprites_sheet::frame & f = _sheet->get_frame(idx);
+    return sprite(idx, f.source_w, f.source_h, _sheet);
+  }
   
   // get sprites_sheet powering this animation
   const sprites_sheet * sheet() const { return _sheet; }
@@ -104,7 +119,7 @@ public:
 private:
   
   // animation details
-  SDL_TimerID _timer;
+  int _slot;
   anim_mode _mode;
   const sprites_sheet * _sheet;
   unsigned int _frame_duration;
@@ -117,4 +132,53 @@ private:
 };
 
 
+/**
+ * the anim_scheduler class
+ * Keeps state of all running animations in flat arrays
+ * and advances them in a single pass once per frame.
+ * Animations must be started, stopped and updated from
+ * the main thread, events are fired from update().
+ */
+class anim_scheduler {
+public:
+  static anim_scheduler * instance();
+
+  // advance all running animations to 'ticks' milliseconds
+  void update(uint32_t ticks);
+
+  // number of running animations
+  size_t size() const { return _owner.size(); }
+
+private:
+  friend class anim;
+
+  anim_scheduler();
+
+  int add(anim * a);
+  void remove(anim * a);
+
+  // update state of a running animation after reset or set_current
+  void sync(anim * a);
+
+  int current(int slot) const { return _current[slot]; }
+
+  uint32_t _last_ticks;
+
+  // per animation state, indexed by anim::_slot
+  std::vector<anim*> _owner;
+  std::vector<int32_t> _elapsed;
+  std::vector<int32_t> _duration;
+  std::vector<int32_t> _phase;
+  std::vector<int32_t> _span;
+  std::vector<int32_t> _period;
+  std::vector<int32_t> _from;
+  std::vector<int32_t> _mod;
+  std::vector<int32_t> _mode;
+  std::vector<int32_t> _current;
+  std::vector<uint8_t> _finished;
+
+  // finished animations waiting for their 'stopped' events
+  std::vector<anim*> _stopping;
+};
+
 #endif //_GM_ANIMATION_H_
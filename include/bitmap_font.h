@@ -0,0 +1,72 @@
+/*
+ * GMLib - The GMLib library.
+ * Copyright Stanislav Yudin, 2014-2016
+ *
+ * This module implements prebaked bitmap fonts.
+ * Glyphs and metrics are read from BMFont (AngelCode) text
+ * descriptors and drawn from page textures as batches of
+ * textured quads, FreeType is not involved at all.
+ */
+
+#ifndef _GM_BITMAP_FONT_H_
+#define _GM_BITMAP_FONT_H_
+
+#include "engine.h"
+#include "texture.h"
+
+class bitmap_font : public base_font {
+public:
+
+  /* glyph location on a page and offset from the pen */
+  struct glyph {
+    int page;
+    rect clip;
+    int xoffset;
+    int yoffset;
+  };
+
+  bitmap_font();
+  /* load a .fnt descriptor, pages are relative to its folder */
+  bitmap_font(const std::string & file_path);
+  /* same from descriptor contents */
+  bitmap_font(const std::string & name, const char * data, size_t size);
+  virtual ~bitmap_font();
+
+  void load(const std::string & file_path);
+  void load(const std::string & name, const char * data, size_t size);
+
+  virtual bool is_loaded() const { return !_pages.empty(); }
+  virtual std::string tostr() const;
+
+  const glyph & get_glyph(uint8_t ch) const { return _glyphs[ch]; }
+  size_t pages_count() const { return _pages.size(); }
+  // distance from the top of a line to the baseline
+  int base() const { return _base; }
+
+  /* glyphs are prebaked, blended is ignored */
+  virtual void render_text(SDL_Renderer * r, const std::string & text,
+                           const point & at, const color & clr,
+                           bool blended = false) const;
+
+protected:
+  // pairs are read with the descriptor
+  virtual int load_kerning(uint8_t, uint8_t) const { return 0; }
+
+private:
+  void clear();
+
+  // 8-bit text as with TTF_RenderText, page < 0 if not in the font
+  glyph _glyphs[256];
+  std::vector<texture*> _pages;
+  int _base;
+  int _page_w;
+  int _page_h;
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+  // per page vertex batches reused between calls
+  mutable std::vector< std::vector<SDL_Vertex> > _batches;
+  mutable std::vector<int> _indices;
+#endif
+};
+
+#endif //_GM_BITMAP_FONT_H_
@@ -30,8 +30,10 @@
 #include <cctype>
 #include <set>
 #include <list>
+#include <deque>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <memory>
 #include <algorithm>
 #include <exception>
@@ -100,6 +102,8 @@ SDL_Texture* GM_CreateTexture(int width, int height,
 SDL_Surface* GM_LoadSurface(const std::string& file_path);
 SDL_Texture* GM_LoadTexture(const std::string& file_path);
 TTF_Font*    GM_LoadFont(const std::string& file_path, int ptsize);
+/* open font from a buffer, it must outlive returned font */
+TTF_Font*    GM_LoadFontMem(const void * data, size_t size, int ptsize);
 
 /* Ticks Timer */
 class timer {
@@ -256,37 +260,99 @@ bool operator<= (rect& a, rect& b);
 bool operator> (rect& a, rect& b);
 bool operator>= (rect& a, rect& b);
 
-/* TTF_Font wrapper */
-class ttf_font {
+class glyph_atlas;
+class sdf_face;
+
+/* Common interface of fonts accepted by text rendering and UI controls.
+   Metrics are cached by implementations on load, kerning of a pair
+   is fetched once with load_kerning */
+class base_font {
 
 protected:
   std::string _fname;
-  TTF_Font * _f;
   size_t _pts;
+  int _advance[256];
+  int _height;
+  bool _kerning;
+  // unknown entries are INT16_MIN
+  mutable std::vector<int16_t> _kerning_pairs;
+
+  virtual int load_kerning(uint8_t prev, uint8_t ch) const = 0;
+
+public:
+  base_font():_pts(0), _height(0), _kerning(false) {}
+  virtual ~base_font() {}
+
+  size_t pts() const { return _pts; }
+  const std::string & filename() const { return _fname; }
+  virtual bool is_loaded() const = 0;
+  virtual std::string tostr() const = 0;
+
+  /* cached metrics of 8-bit characters */
+  int glyph_advance(uint8_t ch) const { return _advance[ch]; }
+  int kerning(uint8_t prev, uint8_t ch) const;
+  int line_height() const { return _height; }
+  rect get_text_rect(const std::string& text) const;
+
+  /* draw text with top left corner at given point,
+     blended selects anti-aliased glyphs where font has both */
+  virtual void render_text(SDL_Renderer * r, const std::string & text,
+                           const point & at, const color & clr,
+                           bool blended = false) const = 0;
+};
+
+/* TTF_Font wrapper, or a size of a shared distance field face */
+class ttf_font : public base_font {
+
+protected:
+  TTF_Font * _f;
+  const sdf_face * _sdf;
+  // lazily created solid & blended glyph atlases
+  mutable glyph_atlas * _atlas[2];
+
+  void load_metrics();
+  virtual int load_kerning(uint8_t prev, uint8_t ch) const;
 
 public:
-  ttf_font():_f(nullptr), _pts(0) {}
+  ttf_font():_f(nullptr), _sdf(nullptr) { _atlas[0] = _atlas[1] = nullptr; }
 
   ttf_font(const std::string & file_path, size_t pts):
     _f(nullptr),
-    _pts(pts)
+    _sdf(nullptr)
   {
+    _atlas[0] = _atlas[1] = nullptr;
     load(file_path, pts);
   }
 
-  void load(const std::string & file_path, size_t pts);
+  /* glyphs are resampled from the face, it must outlive the font */
+  ttf_font(const sdf_face * face, size_t pts):
+    _f(nullptr),
+    _sdf(nullptr)
+  {
+    _atlas[0] = _atlas[1] = nullptr;
+    load(face, pts);
+  }
 
-  size_t pts() const { return _pts; }
-  TTF_Font * get_font() const { return _f; }
-  bool is_loaded() const { return (_f != nullptr); }
-  const std::string & filename() const { return _fname; }
-  virtual ~ttf_font()
+  /* font file contents are not copied, data must outlive the font */
+  ttf_font(const std::string & name, const void * data, size_t size, size_t pts):
+    _f(nullptr),
+    _sdf(nullptr)
   {
-    if (_f != nullptr)
-      TTF_CloseFont(_f);
+    _atlas[0] = _atlas[1] = nullptr;
+    load(name, data, size, pts);
   }
 
-  std::string tostr() const
+  void load(const std::string & file_path, size_t pts);
+  void load(const std::string & name, const void * data, size_t size, size_t pts);
+  void load(const sdf_face * face, size_t pts);
+
+  TTF_Font * get_font() const { return _f; }
+  const sdf_face * get_sdf_face() const { return _sdf; }
+  float sdf_scale() const;
+  virtual bool is_loaded() const { return (_f != nullptr || _sdf != nullptr); }
+  virtual ~ttf_font();
+
+  virtual std::string tostr() const
   {
     std::stringstream ss;
     ss << "font< " << _fname \
@@ -294,13 +360,50 @@ public:
     return ss.str();
   }
 
-  /* text printing */
+  /* text printing, not available for distance field fonts */
   SDL_Surface * print_solid(const std::string & text,
                             const color & clr) const;
   SDL_Surface * print_blended(const std::string & text,
                             const color & clr) const;
-  rect get_text_rect(const std::string& text) const;
-  
+
+  /* draw text from the glyph atlas, no per-string rasterization */
+  virtual void render_text(SDL_Renderer * r, const std::string & text,
+                           const point & at, const color & clr,
+                           bool blended = false) const;
+  glyph_atlas * get_atlas(bool blended) const;
+};
+
+/* Widths of all prefixes of a string drawn with a font,
+   updated in place on edits so measuring does not walk the text */
+class text_widths {
+public:
+  text_widths(): _font(nullptr), _x(1, 0) {}
+
+  /* measure whole text */
+  void assign(const base_font * f, const std::string & text);
+
+  /* update after 'count' chars were inserted at 'pos' of 'text' */
+  void insert(const std::string & text, size_t pos, size_t count);
+
+  /* update after 'count' chars were erased at 'pos' of 'text' */
+  void erase(const std::string & text, size_t pos, size_t count);
+
+  /* width of text.substr(0, idx) */
+  int x_at(size_t idx) const { return idx < _x.size() ? _x[idx] : _x.back(); }
+
+  /* index of a char boundary closest to x */
+  size_t index_at(int x) const;
+
+  int width() const { return _x.back(); }
+  size_t length() const { return _x.size() - 1; }
+  const base_font * font() const { return _font; }
+
+private:
+  // recompute _x[from + 1 .. to] from text
+  void measure(const std::string & text, size_t from, size_t to);
+
+  const base_font * _font;
+  std::vector<int> _x;
 };
 
 /* SDL_Error exception wrapper */
@@ -487,6 +590,20 @@ void GM_EndFrame();
 /* Main game loop. Returns only on exit. */
 void GM_Loop();
 
+/* Enable redraw of the damaged regions only. The frame is kept in
+   a target texture, damaged regions are cleared and redrawn under clip
+   and frames without damage are not presented. UI controls and particle
+   emitters report their changes, other screen components must report
+   theirs with GM_AddDamage or GM_DamageAll from on_update. */
+void GM_SetPartialRedraw(bool enabled);
+bool GM_GetPartialRedraw();
+
+/* Add region of the display to redraw on the next frame */
+void GM_AddDamage(const SDL_Rect & r);
+
+/* Redraw the whole display on the next frame */
+void GM_DamageAll();
+
 /* Get miliseconds elapsed since start of the current frame */
 uint32_t GM_GetFrameTicks();
 
@@ -0,0 +1,63 @@
+/*
+ * GMLib - The GMLib library.
+ * Copyright Stanislav Yudin, 2014-2016
+ *
+ * This module implements the fonts registry.
+ * Font files are memory-mapped once and every size of a file
+ * is opened from the same mapping. Fonts are referred to with
+ * interned integer handles, lookups are thread safe.
+ * BMFont descriptors (.fnt) are registered as bitmap fonts.
+ */
+
+#ifndef _GM_FONT_REGISTRY_H_
+#define _GM_FONT_REGISTRY_H_
+
+#include "engine.h"
+
+class font_registry {
+public:
+  typedef int font_id;
+  static const font_id invalid_id = -1;
+
+  static font_registry * instance();
+
+  /* get handle of a size of font file, it is opened on first request,
+     distance field fonts share one face for all sizes of a file,
+     size and sdf are ignored for prebaked bitmap fonts */
+  font_id intern(const std::string & font_file, size_t pts, bool sdf = false);
+
+  /* font of a handle, it stays valid until release */
+  base_font * get(font_id id);
+
+  base_font * load(const std::string & font_file, size_t pts, bool sdf = false)
+  {
+    return get(intern(font_file, pts, sdf));
+  }
+
+  /* intern all "font" properties found in a theme */
+  void preload(const json & theme);
+
+  /* close all fonts and unmap files, handles become invalid */
+  void release();
+
+  size_t fonts_count();
+  size_t files_count();
+
+private:
+  struct mapped_file;
+
+  font_registry();
+  ~font_registry();
+
+  mapped_file * get_file(const std::string & font_file);
+
+  sdl_mutex _m;
+  // file name -> index in _files
+  std::map<std::string, int> _file_ids;
+  std::vector<mapped_file *> _files;
+  // (file index, pts, sdf) -> font handle
+  std::map<uint64_t, font_id> _ids;
+  std::vector<base_font *> _fonts;
+};
+
+#endif //_GM_FONT_REGISTRY_H_
@@ -0,0 +1,66 @@
+/*
+ * GMLib - The GMLib library.
+ * Copyright Stanislav Yudin, 2014-2016
+ *
+ * This module implements glyph atlases for text rendering.
+ * Glyphs of a font are rasterized once on first use into
+ * shared page textures and strings are drawn as batches of
+ * textured quads, so changing text does not touch FreeType.
+ */
+
+#ifndef _GM_GLYPH_ATLAS_H_
+#define _GM_GLYPH_ATLAS_H_
+
+#include "engine.h"
+#include "texture.h"
+
+class glyph_atlas {
+public:
+  // size of atlas page textures
+  static const int page_width = 512;
+  static const int page_height = 512;
+
+  /* glyph location on a page */
+  struct glyph {
+    int page;
+    rect clip;
+    int advance;
+  };
+
+  /* create an empty atlas of white glyphs rendered with the font */
+  glyph_atlas(const ttf_font * f, bool blended);
+  ~glyph_atlas();
+
+  /* get glyph of a character, it is rasterized if not there yet */
+  const glyph & get_glyph(uint8_t ch);
+
+  /* draw text with top left corner at given point */
+  void render(SDL_Renderer * r, const std::string & text, const point & at, const color & clr);
+
+  bool is_blended() const { return _blended; }
+  size_t pages_count() const { return _pages.size(); }
+
+private:
+  void add_glyph(uint8_t ch);
+  void add_page();
+
+  const ttf_font * _font;
+  bool _blended;
+
+  // 8-bit text as with TTF_RenderText, slot is loaded if page >= 0
+  glyph _glyphs[256];
+
+  std::vector<texture*> _pages;
+  // shelf packing state of the last page
+  int _shelf_x;
+  int _shelf_y;
+  int _shelf_h;
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+  // per page vertex batches reused between calls
+  std::vector< std::vector<SDL_Vertex> > _batches;
+  std::vector<int> _indices;
+#endif
+};
+
+#endif //_GM_GLYPH_ATLAS_H_
@@ -11,6 +11,10 @@
  * texture size supported by SDL. The class will initialize a number of sub-textures (fragments)
  * to actually hold parts of the bigger overall texture. These textures all will be with
  * access = SDL_TEXTUREACCESS_TARGET for rendering onto them via multi_texture::render_texture
+ *
+ * Optionally each fragment keeps a pyramid of half-resolution copies of itself
+ * (see set_lod_levels). Regions modified by render_* calls are marked dirty and
+ * only those are re-sampled into lower levels when a scaled-down render needs them.
  */
 class multi_texture {
 public:
@@ -28,15 +32,31 @@ public:
     // create a new fragment of given size at position
     fragment(rect & pos);
 
-    ~fragment() {}
+    ~fragment();
     // get fragment size and position on multi_texture
     const rect & pos() { return _pos; }
     // get underlying fragment's texture
     texture & get_texture() { return _tx; }
 
+    // (re)create given number of half-resolution levels
+    void set_lod_levels(int levels);
+    int lod_levels() const { return (int)_levels.size(); }
+
+    // get texture of a level, 0 is the fragment's texture itself
+    texture & get_level(int level);
+
+    // mark an area in fragment's coordinates as modified
+    void invalidate(const rect & area);
+
+    // re-sample dirty area into all lower levels
+    void update_levels(SDL_Renderer * r);
+
   private:
     rect _pos;
     texture _tx;
+    std::vector<texture*> _levels;
+    // modified area of the base texture, empty if levels are up to date
+    rect _dirty;
   };
 
   /* create a new multi_texture instance */
@@ -52,8 +72,15 @@ public:
   /* render this multi_texture with given renderer at given screen point */
   void render(SDL_Renderer *, const point & at = point(0, 0));
 
+  /* render 'src' area of this multi_texture scaled into 'dst' on screen,
+     the closest level of detail is picked if there are any */
   void render(SDL_Renderer *, const rect & src, const rect & dst);
 
+  /* keep given number of half-resolution levels for each fragment,
+     0 disables levels of detail */
+  void set_lod_levels(int levels);
+  int lod_levels() const { return _lod_levels; }
+
   /* render 'texture' instance onto this multi_texture at given point */
   void render_texture(SDL_Renderer *, const texture & tx, const point & at = point(0, 0));
 
@@ -65,11 +92,32 @@ public:
   void render_fill_rect(SDL_Renderer *, const rect &);
   void render_clear(SDL_Renderer *);
 
+  /* baked content cache. fragments pixels are stored in a tiled file keyed
+     by 'content_hash' of whatever produced them. load_cache returns false
+     if the file is missing or stale so the content should be baked and
+     saved again */
+  bool load_cache(SDL_Renderer *, const std::string & file_path, uint64_t content_hash);
+  void save_cache(SDL_Renderer *, const std::string & file_path, uint64_t content_hash,
+                  bool compressed = true);
+
+  /* FNV-1a hash of a data block, chain 'seed' to hash several blocks */
+  static uint64_t hash_content(const void * data, size_t len,
+                               uint64_t seed = 14695981039346656037ULL);
+  static uint64_t hash_content(const std::string & data,
+                               uint64_t seed = 14695981039346656037ULL)
+  {
+    return hash_content(data.c_str(), data.size(), seed);
+  }
+
 private:
   void init(int fragments_w = 0, int fragments_h = 0);
 
+  // pick a level of detail to render 'src' into 'dst'
+  int select_level(const rect & src, const rect & dst) const;
+
   int _width;
   int _height;
+  int _lod_levels;
   container<fragment*> _fragments;
 };
 
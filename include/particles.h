@@ -0,0 +1,144 @@
+/*
+ * GMLib - The GMLib library.
+ * Copyright Stanislav Yudin, 2014-2016
+ *
+ * This module implements particle emitters as screen components.
+ * Particles are kept in structure-of-arrays buffers, simulated in
+ * a vectorized pass optionally split across worker threads and
+ * drawn with a single batched geometry call per emitter.
+ */
+
+#ifndef _GM_PARTICLES_H_
+#define _GM_PARTICLES_H_
+
+#include "engine.h"
+#include "sprite.h"
+
+class particle_emitter : public screen::component {
+public:
+
+  /* emission and simulation parameters */
+  struct settings {
+    // particles emitted per second
+    float rate;
+    // lifetime range in seconds
+    float life_min;
+    float life_max;
+    // initial speed range in pixels per second
+    float speed_min;
+    float speed_max;
+    // emission direction range in degrees, 0 points right
+    float angle_min;
+    float angle_max;
+    // acceleration in pixels per second^2
+    float gravity_x;
+    float gravity_y;
+    // particle size at birth and at death
+    float size_start;
+    float size_end;
+    // particle color at birth and at death
+    color color_start;
+    color color_end;
+
+    settings();
+  };
+
+  /* create an emitter for up to 'capacity' live particles drawn with
+     a sprites sheet frame or as colored squares if sheet is NULL */
+  particle_emitter(screen * s, size_t capacity,
+                   const sprites_sheet * sheet = NULL, size_t frame = 0);
+  virtual ~particle_emitter();
+
+  settings & get_settings() { return _settings; }
+  void set_settings(const settings & st) { _settings = st; }
+
+  /* emitter position in screen coordinates */
+  const point & position() const { return _pos; }
+  void set_position(const point & pos) { _pos = pos; }
+
+  /* continuous emission on/off */
+  bool active() const { return _active; }
+  void set_active(bool a) { _active = a; }
+
+  /* split simulation across given number of threads,
+     workers are started once on the next update and reused */
+  void set_threads(int threads) { _threads = max(threads, 1); }
+
+  /* emit a number of particles at once */
+  void burst(size_t count);
+
+  /* remove all live particles */
+  void clear() { _count = 0; }
+
+  size_t count() const { return _count; }
+  size_t capacity() const { return _capacity; }
+
+  virtual void render(SDL_Renderer * r);
+  virtual void on_update(screen *);
+  virtual void on_event(SDL_Event *) {}
+
+private:
+  // advance particles [from, to) by dt seconds
+  void simulate(size_t from, size_t to, float dt);
+  // remove particles which reached end of life
+  void compact();
+  float random(float from, float to);
+  // screen area covered by live particles
+  rect particle_bounds() const;
+
+  // persistent thread simulating a range given each frame
+  struct worker {
+    particle_emitter * emitter;
+    SDL_Thread * thread;
+    size_t from;
+    size_t to;
+  };
+  static int simulate_worker(void * param);
+  void start_workers(size_t n);
+  void stop_workers();
+
+  settings _settings;
+  point _pos;
+  bool _active;
+  int _threads;
+
+  const sprites_sheet * _sheet;
+  rect _clip;
+
+  size_t _capacity;
+  size_t _count;
+  float _emit_acc;
+  uint32_t _last_ticks;
+  float _dt;
+  uint32_t _seed;
+  // area drawn by the last frame, damaged on partial redraw
+  rect _bounds;
+
+  // worker pool, woken by a new frame number and
+  // waited for until no ranges are pending
+  std::vector<worker> _workers;
+  // threads setting the pool was started for
+  int _pool_threads;
+  SDL_mutex * _pool_mx;
+  SDL_cond * _pool_wake;
+  SDL_cond * _pool_done;
+  uint32_t _pool_frame;
+  size_t _pool_pending;
+  bool _pool_quit;
+
+  // particles state
+  std::vector<float> _x;
+  std::vector<float> _y;
+  std::vector<float> _vx;
+  std::vector<float> _vy;
+  std::vector<float> _age;
+  std::vector<float> _life;
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+  // draw batch buffers
+  std::vector<SDL_Vertex> _vertices;
+  std::vector<int> _indices;
+#endif
+};
+
+#endif //_GM_PARTICLES_H_
@@ -0,0 +1,59 @@
+/*
+ * GMLib - The GMLib library.
+ * Copyright Stanislav Yudin, 2014-2016
+ *
+ * This module implements signed distance field font faces.
+ * A face rasterizes glyphs of a TTF file once at a base size
+ * and keeps their distance fields, glyphs of any other size
+ * are then resampled from those fields without FreeType.
+ */
+
+#ifndef _GM_SDF_FONT_H_
+#define _GM_SDF_FONT_H_
+
+#include "engine.h"
+
+class sdf_face {
+public:
+  // size glyphs are rasterized at to build distance fields
+  static const int base_size = 32;
+  // distance in base size pixels covered by the field
+  static const int spread = 4;
+
+  /* distance field of a glyph box (pen aligned, font height tall) */
+  struct glyph {
+    int w;
+    int h;
+    int advance;
+    // (w + 2 * spread) * (h + 2 * spread) values, 128 is the edge
+    std::vector<uint8_t> field;
+  };
+
+  /* load a TTF file and build fields of all 8-bit glyphs */
+  sdf_face(const std::string & file_path);
+  /* same from file contents, data must outlive the face */
+  sdf_face(const std::string & name, const void * data, size_t size);
+  ~sdf_face();
+
+  const std::string & filename() const { return _fname; }
+
+  /* metrics at base size */
+  const glyph & get_glyph(uint8_t ch) const { return _glyphs[ch]; }
+  int height() const { return _height; }
+  int kerning(uint8_t prev, uint8_t ch) const;
+
+  /* produce a white glyph surface for given scale of base size,
+     edges are anti-aliased for blended and hard for solid style */
+  SDL_Surface * render_glyph(uint8_t ch, float scale, bool blended) const;
+
+private:
+  void build();
+  void build_field(glyph & g, SDL_Surface * s);
+
+  std::string _fname;
+  TTF_Font * _f;
+  int _height;
+  glyph _glyphs[256];
+};
+
+#endif //_GM_SDF_FONT_H_
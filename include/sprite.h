@@ -13,12 +13,37 @@
 #include "engine.h"
 #include "texture.h"
 
-/* Sprites Sheet */
+/* Sprites Sheet
+   A uniform grid of sprites or an atlas described by a JSON file
+   in TexturePacker format (hash or array of "frames") with
+   trimmed, rotated and named frames of different sizes */
 
 class sprites_sheet : public texture {
 public:
+
+  /* a single sprite area on the sheet */
+  struct frame {
+    std::string name;
+    // area on the sheet, w and h are swapped for rotated frames
+    rect clip;
+    // trimmed area inside of the original sprite
+    rect trimmed;
+    // original sprite size
+    uint32_t source_w;
+    uint32_t source_h;
+    // stored rotated 90 degrees clockwise
+    bool rotated;
+    // rotation center relative to original sprite size
+    float pivot_x;
+    float pivot_y;
+  };
+
+  /* grid of equally sized sprites */
   sprites_sheet(const std::string & file_path, uint32_t sprite_w, uint32_t sprite_h);
 
+  /* atlas from a JSON file, the image is resolved next to it */
+  sprites_sheet(const std::string & atlas_path);
+
   inline bool operator== (sprites_sheet & other) {
     return (get_texture() == other.get_texture() && _rows == other._rows && _cols == other._cols);
   }
@@ -26,15 +51,41 @@ public:
     return !(*this == other);
   }
 
-  rect get_sprite_cliprect(size_t idx) const;
-  uint32_t sprite_width() const { return width() / _cols; }
-  uint32_t sprite_height() const { return height() / _rows; }
+  rect get_sprite_cliprect(size_t idx) const { return get_frame(idx).clip; }
+  uint32_t sprite_width() const { return _sprite_w; }
+  uint32_t sprite_height() const { return _sprite_h; }
   uint32_t rows() const { return _rows; }
   uint32_t cols() const { return _cols; }
 
+  /* frames access, atlas frames are sorted by name for both
+     hash and array atlases */
+  bool is_atlas() const { return _atlas; }
+  size_t frames_count() const { return _frames.size(); }
+  const frame & get_frame(size_t idx) const
+  {
+    if (idx >= _frames.size()) {
+      SDL_Log("%s - invalid frame idx=%zu of %zu",
+        __METHOD_NAME__, idx, _frames.size());
+      throw std::runtime_error("Invalid sprites sheet frame index");
+    }
+    return _frames[idx];
+  }
+
+  /* get index of a named frame */
+  size_t find_frame(const std::string & name) const;
+
 private:
+  sprites_sheet(const std::string & atlas_path, const json & atlas);
+  void load_atlas(const json & atlas);
+
+  bool _atlas;
   uint32_t _cols;
   uint32_t _rows;
+  uint32_t _sprite_w;
+  uint32_t _sprite_h;
+
+  std::vector<frame> _frames;
+  std::map<std::string, size_t> _names;
 };
 
 /* Sprite */
@@ -69,6 +120,9 @@ public:
 
   /* create new sprite with texture index */
   sprite(size_t tex_idx, int px_w, int px_h, sprites_sheet const * sheet);
+
+  /* create new sprite of a named atlas frame */
+  sprite(const std::string & frame_name, sprites_sheet const * sheet);
   virtual ~sprite() {}
 
   /* get center point based on rect */
@@ -81,6 +135,7 @@ public:
   /* render a sprite with altered src rect at absolute renderer position.
      dsrc's x and y are added to the sprites's src rect.
      dsrc's w and h are copied to src if w and h both > 0.
+     trimming and rotation of atlas frames are not applied to altered src.
   */
   void render(SDL_Renderer * r, const rect & dsrc, const rect & dst) const;
   void render(SDL_Renderer * r, const rect & dsrc, const point & dst_pnt) const;
@@ -27,18 +27,29 @@ public:
   /**
       Class texture::clip_context
       Temporary setup of the renderer clip area
-      with SDL_RenderSetClipRect and reset on exit
+      with SDL_RenderSetClipRect and reset on exit.
+      Contexts nest, the area is limited by the enclosing
+      clip, i.e. of the damaged region of a frame, and
+      it is restored on exit.
       */
   class clip_context {
   private:
     SDL_Renderer *_r;
     rect _orig;
+    bool _clipped;
 
   public:
     clip_context(SDL_Renderer *r, const rect & clip):
-      _r(r)
+      _r(r), _clipped(SDL_RenderIsClipEnabled(r) == SDL_TRUE)
     {
-      int rc = SDL_RenderSetClipRect(r, &clip);
+      rect area = clip;
+      if (_clipped) {
+        SDL_RenderGetClipRect(r, &_orig);
+        // empty intersection must still clip everything
+        if (!SDL_IntersectRect(&clip, &_orig, &area))
+          area = rect(_orig.x, _orig.y, 0, 0);
+      }
+      int rc = SDL_RenderSetClipRect(r, &area);
       if (rc != 0)
         throw sdl_exception();
     }
@@ -46,7 +57,7 @@ public:
     virtual ~clip_context()
     {
       assert(_r);
-      int rc = SDL_RenderSetClipRect(_r, NULL);
+      int rc = SDL_RenderSetClipRect(_r, _clipped ? &_orig : NULL);
       if (rc != 0)
         throw sdl_exception();
     }
@@ -56,12 +67,17 @@ public:
   /** 
       Class texture::render_context   
       Temporary setup a texture with access = SDL_TEXTUREACCESS_STREAMING
-      as a target of SDL_Renderer calls and reset back on destruction
+      as a target of SDL_Renderer calls and reset back on destruction.
+      Renderer is presented on destruction unless disabled, i.e. for
+      textures rendered in the middle of a frame. Clip area of the
+      previous target is not applied to the texture and restored
+      with the target.
       */
   class render_context {
   public:
-    render_context(texture * t, SDL_Renderer * r):
-      _r(r), _t(t), _prev(NULL) 
+    render_context(texture * t, SDL_Renderer * r, bool present = true):
+      _r(r), _t(t), _prev(NULL), _present(present),
+      _clipped(SDL_RenderIsClipEnabled(r) == SDL_TRUE)
     {
       if (t->access() != SDL_TEXTUREACCESS_TARGET) {
         SDL_Log("%s - unsupported target texture type. it must be SDL_TEXTUREACCESS_TARGET",
@@ -69,25 +85,33 @@ public:
         throw std::runtime_error("Unsupported target texture type for render_context");
       }
       _prev = SDL_GetRenderTarget(_r);
+      if (_clipped)
+        SDL_RenderGetClipRect(_r, &_clip);
       int ret = SDL_SetRenderTarget(_r, _t->get_texture());
       if (ret != 0) {
         throw sdl_exception();
       }
+      SDL_RenderSetClipRect(_r, NULL);
     }
 
     virtual ~render_context()
     {
-      SDL_RenderPresent(_r);
+      if (_present)
+        SDL_RenderPresent(_r);
       int ret = SDL_SetRenderTarget(_r, _prev);
       if (ret != 0) {
         throw sdl_exception();
       }
+      SDL_RenderSetClipRect(_r, _clipped ? &_clip : NULL);
     }
 
   private:
     SDL_Renderer * _r;
     texture * _t;
     SDL_Texture * _prev;
+    bool _present;
+    bool _clipped;
+    rect _clip;
   };
 
   /* Create an empty texture */
@@ -194,6 +218,10 @@ public:
               double angle = 0.0, SDL_Point* center = NULL, SDL_RendererFlip flip = SDL_FLIP_NONE) const;
   void render(SDL_Renderer* r, const point & topleft, 
               double angle = 0.0, SDL_Point* center = NULL, SDL_RendererFlip flip = SDL_FLIP_NONE) const;
+  /* fill polygon with this texture repeated from the offset,
+     with a single geometry call for the cached polygon shape */
+  void render_polygon(SDL_Renderer* r, const std::vector<point> & pts,
+                      const point & offset = point(0, 0)) const;
 
   /* pixels access */
   void lock();
@@ -51,17 +51,7 @@ public:
   virtual std::string get_type_name() const { return "box"; }
   std::string get_box_type_name() const;
 
-  virtual ~box() 
-  {
-    if (_vscroll != nullptr) {
-      remove_child(_vscroll);
-      ui::destroy(_vscroll);
-    }
-    if (_hscroll != nullptr) {
-      remove_child(_hscroll);
-      ui::destroy(_hscroll);
-    }
-  }
+  virtual ~box();
 
   /* if this box displays scroll bar */
   bool is_scrollbar_hidden() 
@@ -92,8 +82,8 @@ public:
   const h_align & get_halign() const { return _ha; }
   const v_align & get_valign() const { return _va; }
 
-  void set_halign(const h_align & ha) { _ha = ha; }
-  void set_valign(const v_align & va) { _va = va; }
+  void set_halign(const h_align & ha) { _ha = ha; request_layout(); }
+  void set_valign(const v_align & va) { _va = va; request_layout(); }
 
   /* box contents padding */
   void set_padding(uint32_t pad) 
@@ -102,12 +92,18 @@ public:
     _pad.left = pad;
     _pad.bottom = pad;
     _pad.right = pad;
+    invalidate_measure();
   }
-  void set_padding(const padding & pad) { _pad = pad; }
+  void set_padding(const padding & pad) { _pad = pad; invalidate_measure(); }
   const padding & get_padding() { return _pad; }
 
   const int get_margin() const { return _margin; }
-  void set_margin(const int & m) { _margin = m; }
+  void set_margin(const int & m) { _margin = m; invalidate_measure(); }
+
+  /* start a new line or column of children when the next
+     one does not fit, instead of shrinking them */
+  bool get_wrap() const { return _wrap; }
+  void set_wrap(bool w) { _wrap = w; request_layout(); }
 
   virtual void update();
   
@@ -132,15 +128,34 @@ public:
   // scroll box width given delta pixels
   void do_scroll(int dx, int dy);
 
-  // auto-positioning of children controls
+  // auto-positioning of children controls, children are measured
+  // and then arranged with their flex weights and min/max sizes.
   // children can override to implement more layouting options
   virtual void update_children();
 
+  /* mark layout of children stale, it is updated once
+     by the next layout pass before the frame is drawn */
+  void request_layout();
+  bool layout_requested() const { return _layout_requested; }
+
+  /* batch changes of children, layout is deferred until the
+     outermost end_update and done there once if requested */
+  void begin_update();
+  void end_update();
+
+  /* update layout of all boxes requested it, called by
+     the manager before controls are updated and drawn */
+  static void layout_pending();
+
   // remove all children of this box
   void clear_children();
 
 protected:
 
+  /* size of children stacked without wrap, for boxes with zero sides */
+  virtual point measure_content();
+  virtual void layout_invalidated();
+
   // update selection on the box
   void switch_selection(control * target);
   
@@ -158,10 +173,6 @@ protected:
   // v_align effective for hbox
   v_align _va;
 
-  // offscreen render target texture for children
-  texture _body;
-  bool _dirty;
-
   // children available area bounds
   padding _pad;
   // actual area occupied by children
@@ -179,6 +190,13 @@ protected:
 
   // box selection
   control * _selected_ctl;
+
+  // children lines are wrapped
+  bool _wrap;
+
+  // deferred layout state
+  bool _layout_requested;
+  int _update_depth;
 };
 
 /**
@@ -32,8 +32,9 @@ public:
     _pad.left = pad;
     _pad.bottom = pad;
     _pad.right = pad;
+    content_resized();
   }
-  void set_padding(padding & pad) { _pad = pad; }
+  void set_padding(padding & pad) { _pad = pad; content_resized(); }
   const padding & get_padding() { return _pad; }
 
   virtual void load(const json &);
@@ -43,59 +44,60 @@ public:
   const std::string& get_text() { return _text; }
   
   /* Label text font */
-  void set_font(const ttf_font * fnt)
+  void set_font(const base_font * fnt)
   {
     _font = fnt;
-    _dirty = true;
+    mark_dirty();
+    content_resized();
   }
 
-  const ttf_font * get_font() { return _font; }
+  const base_font * get_font() { return _font; }
 
-  void set_font_style(font_style s) { _font_style = s; }
+  void set_font_style(font_style s) { _font_style = s; invalidate(); }
   const font_style get_font_style() { return _font_style; }
 
   /* Idle and hovered color options */
   void set_highlight_color(const color & c)
   {
     _color_highlight = c;
-    _dirty = true;
+    mark_dirty();
   }
   color get_hightlight_color() { return _color_highlight; }
 
   void set_idle_color(const color & c)
   {
     _color_idle = c;
-    _dirty = true;
+    mark_dirty();
   }
   color get_idle_color() { return _color_idle; }
 
   void set_background_color(const color & c)
   {
     _color_back = c;
-    _dirty = true;
+    mark_dirty();
   }
   color get_background_color() { return _color_back; }
 
   void enable_hightlight_on_focus()
   {
     _highlight_on_focus = true;
-    _dirty = true;
+    mark_dirty();
   }
   void disable_hightlight_on_focus()
   {
     _highlight_on_focus = false;
-    _dirty = true;
+    mark_dirty();
   }
 
   void enable_hightlight_on_hover()
   {
     _highlight_on_hover = true;
-    _dirty = true;
+    mark_dirty();
   }
   void disable_hightlight_on_hover()
   {
     _highlight_on_hover = false;
-    _dirty = true;
+    mark_dirty();
   }
 
   /* Label icon */
@@ -107,7 +109,7 @@ public:
   void set_icon_color(color & c)
   {
     _icon_color = c;
-    _dirty = true;
+    mark_dirty();
   }
 
   /* Label rendering */
@@ -128,8 +130,8 @@ public:
   const bool is_pressed() const { return _pressed; }
   const bool is_stuck() const { return _stuck; }
   const bool is_sticky() const { return _sticky; }
-  void set_sticky(bool st) { _sticky = st; if (_sticky) _stuck = false; }
-  void set_stuck(bool st) { if (_sticky) _stuck = st; }
+  void set_sticky(bool st) { _sticky = st; if (_sticky) _stuck = false; mark_dirty(); }
+  void set_stuck(bool st) { if (_sticky) _stuck = st; mark_dirty(); }
 
   const std::string get_style() const { return _style; }
   void set_style(const std::string & st);
@@ -141,11 +143,22 @@ protected:
 
   virtual void paint(SDL_Renderer * r);
 
+  /* text size with padding and icon, for labels with zero sides */
+  virtual point measure_content();
+  /* text, font, icon or padding changed */
+  void content_resized();
+
   /* let derived classes control the "dirty" flag */
-  void mark_dirty() { _dirty = true; }
-  const texture & get_text_texture() const { return _text_tx; }
+  void mark_dirty() { _dirty = true; invalidate(); }
+  const rect & get_text_rect() const { return _text_rect; }
   const point & get_text_offset() const { return _text_offset; }
-  void paint_text(texture & tx, const std::string & text, const ttf_font * fnt, const color & clr);
+
+  /* text prefix widths for cursor placement and hit-testing */
+  const text_widths & get_text_widths() const { return _widths; }
+
+  /* edit text in place keeping prefix widths up to date */
+  void insert_text(size_t pos, const std::string & txt);
+  void erase_text(size_t pos, size_t count);
 
 private:
   void on_hovered(control * target);
@@ -163,7 +176,11 @@ private:
 
   std::string _text;
   point _text_offset;
-  texture _text_tx;
+  // text is drawn from font's glyph atlas each frame,
+  // only its size and color are computed on paint
+  rect _text_rect;
+  color _text_color;
+  text_widths _widths;
   
   icon_pos _icon_pos;
   uint32_t _icon_gap;
@@ -174,7 +191,7 @@ private:
   texture * _icon_tx;
   
   std::string _style;
-  const ttf_font * _font;
+  const base_font * _font;
   font_style _font_style;
 
   color _color_idle;
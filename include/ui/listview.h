@@ -0,0 +1,108 @@
+#ifndef _GMUI_LISTVIEW_H_
+#define _GMUI_LISTVIEW_H_
+
+#include "manager.h"
+
+namespace ui {
+
+class list_view;
+
+/**
+  Items of a list_view. The view asks for the count of items
+  and binds visible ones to its row controls, the same row is
+  bound to another item when it scrolls out of the view.
+*/
+class list_source {
+public:
+  virtual ~list_source() {}
+
+  /* number of items in the list */
+  virtual size_t count() const = 0;
+
+  /* create a row control of the view, a label by default */
+  virtual control * create_row(const rect & pos);
+
+  /* show the item in the row created by create_row,
+     called again when the item or its selection changes */
+  virtual void bind(list_view * view, control * row, size_t item) = 0;
+};
+
+/**
+  UI List View Control.
+  Scrollable list of uniform height rows. Only rows fitting
+  the view and a few above and below it are created and they
+  are bound to items of the source as the list scrolls, so
+  memory and frame cost do not depend on the count of items.
+*/
+class list_view: public control {
+public:
+  static const size_t no_item = (size_t)-1;
+
+  list_view(const rect & pos, int row_height = 20, size_t overscan = 2);
+  virtual ~list_view();
+
+  virtual std::string get_type_name() const { return "list_view"; }
+
+  /* source of items, it is not owned by the view */
+  void set_source(list_source * src);
+  list_source * get_source() const { return _source; }
+
+  /* bind rows again, i.e. when items of the source changed */
+  void refresh();
+
+  int get_row_height() const { return _row_h; }
+  void set_row_height(int h);
+
+  /* extra rows bound above and below the visible ones */
+  size_t get_overscan() const { return _overscan; }
+  void set_overscan(size_t n);
+
+  /* scrolling by pixels */
+  void scroll_to(size_t px);
+  void scroll_by(int px);
+  size_t get_scroll() const { return _scroll; }
+  /* scroll the item into the view */
+  void scroll_to_item(size_t item);
+
+  /* selected item or no_item */
+  size_t get_selected() const { return _selected; }
+  void set_selected(size_t item);
+
+  /* item bound to a row control or no_item */
+  size_t get_row_item(const control * row) const;
+
+  const std::string get_style() const { return _style; }
+  void set_style(const std::string & st);
+
+  virtual void update();
+  virtual void load(const json &);
+  virtual void draw(SDL_Renderer* r, const rect & dst);
+
+private:
+  size_t max_scroll() const;
+  size_t rows_needed() const;
+  void create_rows();
+  void release_rows();
+  void update_rows();
+  void bind_item(size_t item);
+
+  void on_row_click(control * target);
+  void on_wheel(control * target);
+
+  list_source * _source;
+  std::string _style;
+  color _color_back;
+
+  int _row_h;
+  size_t _overscan;
+  size_t _scroll;
+  size_t _selected;
+
+  // rows are reused in a ring, item N is shown by row N % size
+  std::vector<control*> _rows;
+  std::vector<size_t> _row_items;
+};
+
+}; //namespace ui
+
+#endif //_GMUI_LISTVIEW_H_
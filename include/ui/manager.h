@@ -78,10 +78,28 @@ public:
 
   /** UI Control protocol */
   const std::string & identifier() const { return _id; }
-  void set_identifier(const std::string & id) { _id = id; }
+  void set_identifier(const std::string & id);
 
-  /* render control at absolute rect */
+  /* render control at absolute rect. children are placed relative
+     to dst, which is the cache texture rect for cached controls */
   virtual void draw(SDL_Renderer* r, const rect & dst);
+
+  /* render control at dst with draw() or from its cache texture,
+     parents call it to render their children */
+  void render_at(SDL_Renderer* r, const rect & dst);
+
+  /* Get/set caching of the rendered control with its children in a
+     target texture. Cached control is drawn again only after it or
+     any of its children is invalidated, otherwise the texture is
+     copied. Cache has transparent background, so controls with
+     opaque backgrounds composite best. */
+  void set_render_cache(bool c);
+  bool render_cache() const { return _cache_render; }
+
+  /* mark appearance of this control changed, caching parents of it
+     draw it again and its visible area is damaged for the partial
+     redraw. controls call it when their look changes */
+  void invalidate();
   /* per-frame update control state */
   virtual void update();
   /* load properties from data */
@@ -96,7 +114,11 @@ public:
   /* returns order this control is drawn on parent */
   size_t zlevel();
 
-  /* returns pointer to a child of some level of this control */
+  /* returns pointer to a child of some level of this control,
+     the first one in depth-first order if identifier is not unique.
+     Lookups are done in the manager's identifier index while the
+     control is attached to the manager. Controls scheduled for
+     destruction are not found. */
   control * find_child(const std::string & id);
   template<class T> T * find_child(const std::string & id)
   {
@@ -129,6 +151,12 @@ public:
   */
   virtual rect get_absolute_pos() const;
 
+  /* Get the part of the absolute position within all parents, empty if it is
+     scrolled or moved out of them. Both rects are cached until the position,
+     scrolling or parent of this control or of any of its parents changes.
+  */
+  rect get_visible_rect() const;
+
   /* UI Control offscreen rendering support for
      children controls. If this control is a host 
      of children rendered to the offset texture then 
@@ -138,17 +166,65 @@ public:
   */
   virtual rect get_scrolled_rect() const { return _scrolled_rect; }
   
-  /* Get/Set control relative position on parent */
+  /* Get/Set control relative position on parent, its size
+     is the preferred size of the control for layouts */
   const rect& pos() const { return _pos; }
-  void set_pos(const rect& r) { _pos = r; }
+  void set_pos(const rect& r)
+  {
+    if (r.w != _basis.x || r.h != _basis.y) {
+      _basis = point(r.w, r.h);
+      invalidate_measure();
+    }
+    arrange(r);
+  }
+
+  /* Set position assigned by a layout of the parent,
+     the preferred size of the control is kept */
+  void arrange(const rect& r);
+
+  /* Preferred size with min and max sizes applied. Sides of the
+     preferred size which are zero are measured from the content.
+     Result is cached until the control or any of its children
+     changes its measure, then parents are laid out again. */
+  point measure();
+  void invalidate_measure();
+
+  /* Get/set flex weights of the control in a box. Free space along
+     the box direction is split among children by their grow weights,
+     missing space is taken from them by shrink weights and sizes. */
+  int get_grow() const { return _grow; }
+  int get_shrink() const { return _shrink; }
+  void set_flex(int grow, int shrink);
+
+  /* Get/set size constraints of the control in a box,
+     zero sides of the max size are unlimited */
+  const point & get_min_size() const { return _min_size; }
+  const point & get_max_size() const { return _max_size; }
+  void set_min_size(const point & sz);
+  void set_max_size(const point & sz);
 
   /* Get/set visibility of the control */
   bool visible() const { return _visible; }
-  void set_visible(bool v) { _visible = v; }
+  void set_visible(bool v)
+  {
+    if (v == _visible) return;
+    _visible = v;
+    // hidden children are not laid out
+    if (_parent != NULL)
+      _parent->invalidate_measure();
+    layout_changed();
+    invalidate();
+  }
 
   /* Get/set flag to harvest this control on the next cycle */
   bool destroyed() const { return _destroyed; }
-  void set_destroyed(bool d) { _destroyed = d; }
+  void set_destroyed(bool d)
+  {
+    if (d == _destroyed) return;
+    _destroyed = d;
+    layout_changed();
+    invalidate();
+  }
 
   /* Get/set event transparency flag for the control */
   bool proxy() const { return _proxy; } 
@@ -156,7 +232,14 @@ public:
 
   /* Get/set position lock flag for the control */
   bool locked() const { return _locked; }
-  void set_locked(bool s) { _locked = s; }
+  void set_locked(bool s)
+  {
+    if (s == _locked) return;
+    invalidate();
+    _locked = s;
+    invalidate_geometry();
+    invalidate();
+  }
 
   /* Get/set disabled state flag for the control */
   bool disabled() const { return _disabled; }
@@ -195,9 +278,92 @@ protected:
   bool _destroyed;
   bool _disabled;
 
+  /* drop cached rects of this control and of its children,
+     i.e. when scrolled rect changes only children are invalidated */
+  void invalidate_geometry();
+  void invalidate_children_geometry();
+
+  /* count changes of rects, visibility and drawing order
+     of controls to rebuild manager's hit-test index */
+  static void layout_changed();
+  static uint32_t layout_generation();
+
+  /* size of the content for sides of the preferred size which
+     are zero, i.e. of the text of a label. none by default */
+  virtual point measure_content();
+  /* measure of this control or of a child changed, or it was
+     resized. containers lay out their children again */
+  virtual void layout_invalidated() {}
+  /* preferred size has sides measured from the content */
+  bool auto_sized() const { return _basis.x <= 0 || _basis.y <= 0; }
+
 private:
+  friend class manager;
+
+  void update_geometry() const;
+
+  /* depth-first search of a child by identifier, not destroyed */
+  control * search_child(const std::string & id);
+
   /* control unique id */
   std::string _id; 
+  // control is attached to the manager and its identifier is indexed
+  bool _indexed;
+
+  // rendered control and children, see set_render_cache()
+  texture _cache;
+  bool _cache_render;
+  bool _cache_stale;
+
+  // cached absolute and visible rects, valid while
+  // _cached_gen matches current generation
+  mutable rect _abs_pos;
+  mutable rect _visible_rect;
+  mutable uint32_t _cached_gen;
+  uint32_t _geometry_gen;
+
+  // layout properties and cached measure
+  point _basis;
+  point _min_size;
+  point _max_size;
+  int _grow;
+  int _shrink;
+  point _measured;
+  bool _measure_valid;
+};
+
+/*
+  Theme properties of a control type, resolved once when
+  the theme is loaded. Types inherit properties of the theme
+  root they do not set. Missing properties fail on access.
+  */
+class theme_style {
+public:
+  theme_style();
+
+  const base_font * get_font() const;
+  font_style get_font_style() const;
+  const color & get_idle_color() const;
+  const color & get_highlight_color() const;
+  const color & get_back_color() const;
+
+private:
+  friend class manager;
+
+  static const int has_font = 1;
+  static const int has_font_style = 2;
+  static const int has_idle_color = 4;
+  static const int has_highlight_color = 8;
+  static const int has_back_color = 16;
+
+  void require(int prop, const char * name) const;
+
+  int _resolved;
+  const base_font * _font;
+  font_style _font_style;
+  color _idle;
+  color _highlight;
+  color _back;
 };
 
 /*
@@ -264,15 +430,20 @@ public:
   /** UI Theme API */
   const texture & get_theme_sprites() { return _theme_sprites; }
   json get_theme_prop(const std::string & type_name, const std::string & prop_name);
+  /* resolved style of a type, or of the theme root for unknown types */
+  const theme_style & get_style(const std::string & type_name) const;
   color get_idle_color(const std::string & type_name);
   color get_highlight_color(const std::string & type_name);
   color get_back_color(const std::string & type_name);
-  const ttf_font * get_font(const std::string & type_name);
+  const base_font * get_font(const std::string & type_name);
   font_style get_font_style(const std::string & type_name);
 
   /* load cached font */
-  static ttf_font* load_font(const std::string & font_file,
+  static base_font* load_font(const std::string & font_file,
                              const size_t & ptsize);
+  /* load cached size of a shared distance field face */
+  static base_font* load_sdf_font(const std::string & font_file,
+                                 const size_t & ptsize);
   static font_style font_style_from_str(const std::string & s);
 
   /* screen::component protocol overrides */
@@ -289,6 +460,26 @@ private:
   void set_hovered_control(control * target);
   void set_focused_control(control * target);
 
+  /* resolve theme styles of all types in the theme data */
+  void compile_theme();
+  static void compile_style(const json & d, theme_style & s);
+
+  /* Hash index of identifiers of controls attached to the manager,
+     updated as they are added, removed, renamed and destroyed */
+  friend class control;
+  static void index_tree(control * c);
+  static void unindex_tree(control * c);
+  static void unindex(control * c);
+  static void rename_indexed(control * c, const std::string & id);
+  static control * find_indexed(control * root, const std::string & id);
+
+  /* Pointer hit-testing with a uniform grid of visible rects
+     of controls, same result as find_child_at. Rebuilt when
+     layout generation changes. */
+  control * hit_test(const point & at);
+  void rebuild_hit_index();
+  void index_children(const control * parent);
+
   // global pointer position
   point _pointer;
 
@@ -306,6 +497,24 @@ private:
   // Theme settings
   texture _theme_sprites;
   json _theme_data;
+  theme_style _root_style;
+  std::unordered_map<std::string, theme_style> _styles;
+
+  // Pointer hit-test index
+  static const int hit_cell_size = 64;
+
+  struct hit_entry {
+    control * cnt;
+    rect area;
+  };
+  // visible controls in the drawing order
+  std::vector<hit_entry> _hit_entries;
+  // entries overlapping each cell, in the drawing order
+  std::vector< std::vector<uint32_t> > _hit_cells;
+  rect _hit_area;
+  int _hit_cols;
+  int _hit_rows;
+  uint32_t _hit_gen;
 };
 
 
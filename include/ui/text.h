@@ -53,6 +53,7 @@ protected:
   void on_focused(control * target);
   void on_focus_lost(control * target);
   void on_kbd_up(control * target);
+  void on_mouse_down(control * target);
 
   bool _readonly;
   bool _draw_frame;
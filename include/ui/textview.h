@@ -0,0 +1,109 @@
+#ifndef _GMUI_TEXTVIEW_H_
+#define _GMUI_TEXTVIEW_H_
+
+#include "manager.h"
+
+namespace ui {
+
+/**
+  UI Text View Control.
+  Read-only scrollable multi-line text, i.e. for consoles and logs.
+  Paragraphs are kept in fixed size chunks and word wrapped once,
+  only appended or replaced paragraphs are wrapped again. Only rows
+  in the visible part are drawn, directly from the font glyphs.
+*/
+class text_view: public control {
+public:
+  // paragraphs per chunk of the buffer
+  static const size_t chunk_lines = 256;
+
+  text_view(const rect & pos, const padding & pad = padding(2));
+  virtual ~text_view();
+
+  virtual std::string get_type_name() const { return "text_view"; }
+
+  /* add text, each line of it is a new paragraph */
+  void append(const std::string & txt);
+  /* replace text of a paragraph */
+  void set_line(size_t idx, const std::string & txt);
+  const std::string & get_line(size_t idx) const;
+  void clear();
+
+  size_t lines_count() const { return _lines; }
+  /* number of wrapped rows of all paragraphs */
+  size_t rows_count();
+
+  /* drop oldest paragraphs above the limit, 0 is unlimited */
+  void set_max_lines(size_t n);
+  size_t get_max_lines() const { return _max_lines; }
+
+  /* scrolling by wrapped rows, view follows appended text
+     while it is scrolled to the end */
+  void scroll_to(size_t row);
+  void scroll_by(int rows);
+  void scroll_to_end();
+  size_t get_scroll_row() const { return _scroll_row; }
+  bool is_following() const { return _follow; }
+
+  /* text appearance */
+  void set_font(const base_font * fnt);
+  const base_font * get_font() const { return _font; }
+  void set_font_style(font_style s) { _font_style = s; invalidate(); }
+  void set_text_color(const color & c) { _color_idle = c; invalidate(); }
+  void set_background_color(const color & c) { _color_back = c; invalidate(); }
+  void set_padding(const padding & pad) { _pad = pad; invalidate(); }
+
+  const std::string get_style() const { return _style; }
+  void set_style(const std::string & st);
+
+  virtual void load(const json &);
+  virtual void draw(SDL_Renderer* r, const rect & dst);
+
+private:
+  struct paragraph {
+    std::string text;
+    // offsets where wrapped rows after the first one start
+    std::vector<uint32_t> breaks;
+    size_t rows() const { return breaks.size() + 1; }
+  };
+
+  struct chunk {
+    std::vector<paragraph> lines;
+    // rows of all lines, valid if wrap_w is the current width
+    size_t rows;
+    int wrap_w;
+  };
+
+  void wrap(paragraph & p) const;
+  void wrap_chunk(chunk & c);
+  void wrap_stale();
+  chunk & locate(size_t idx, size_t & in_chunk);
+  void trim();
+  int visible_rows() const;
+  size_t max_scroll_row();
+  void on_wheel(control * target);
+
+  padding _pad;
+  std::string _style;
+  const base_font * _font;
+  font_style _font_style;
+  color _color_idle;
+  color _color_back;
+
+  std::deque<chunk> _chunks;
+  size_t _lines;
+  size_t _max_lines;
+  // rows of chunks wrapped for _wrap_w
+  size_t _rows;
+  int _wrap_w;
+
+  size_t _scroll_row;
+  bool _follow;
+
+  // reused for the text of a row while drawing
+  std::string _row;
+};
+
+}; //namespace ui
+
+#endif //_GMUI_TEXTVIEW_H_
@@ -0,0 +1,167 @@
+#include "batch.h"
+#include <vector>
+
+/*
+ * Pixels of the rasterizers waiting to be drawn.
+ * Points and rectangles of the same color blend the same way in any
+ * order, so each kind is drawn with a single call on flush.
+ */
+
+struct batch_state {
+  SDL_Renderer * renderer;
+  SDL_Color color;
+  SDL_BlendMode mode;
+  // open primitives and SDLEx_BeginBatch calls
+  int depth;
+  std::vector<SDL_Point> points;
+  std::vector<SDL_Rect> rects;
+  // polylines are stored one after another
+  std::vector<SDL_Point> line_points;
+  std::vector<int> line_counts;
+
+  bool empty() const
+  {
+    return points.empty() && rects.empty() && line_counts.empty();
+  }
+};
+
+// renderers are used from the main thread only, as SDL requires
+static batch_state g_batch = { NULL, { 0, 0, 0, 0 }, SDL_BLENDMODE_NONE, 0 };
+
+static int batch_flush()
+{
+  if (g_batch.empty())
+    return 0;
+
+  SDL_Renderer * renderer = g_batch.renderer;
+  const SDL_Color & c = g_batch.color;
+  SDL_Color current;
+  SDL_BlendMode mode;
+  int result = 0;
+  result |= SDL_GetRenderDrawColor(renderer, &current.r, &current.g, &current.b, &current.a);
+  result |= SDL_GetRenderDrawBlendMode(renderer, &mode);
+  bool restore_color = (current.r != c.r || current.g != c.g || current.b != c.b || current.a != c.a);
+  bool restore_mode = (mode != g_batch.mode);
+  if (restore_color)
+    result |= SDL_SetRenderDrawColor(renderer, c.r, c.g, c.b, c.a);
+  if (restore_mode)
+    result |= SDL_SetRenderDrawBlendMode(renderer, g_batch.mode);
+
+  if (!g_batch.points.empty())
+    result |= SDL_RenderDrawPoints(renderer, &g_batch.points[0], (int)g_batch.points.size());
+  if (!g_batch.rects.empty())
+    result |= SDL_RenderFillRects(renderer, &g_batch.rects[0], (int)g_batch.rects.size());
+  size_t from = 0;
+  for (size_t i = 0; i < g_batch.line_counts.size(); ++i) {
+    result |= SDL_RenderDrawLines(renderer, &g_batch.line_points[from], g_batch.line_counts[i]);
+    from += g_batch.line_counts[i];
+  }
+
+  if (restore_color)
+    result |= SDL_SetRenderDrawColor(renderer, current.r, current.g, current.b, current.a);
+  if (restore_mode)
+    result |= SDL_SetRenderDrawBlendMode(renderer, mode);
+
+  // keep the capacity for the next primitives
+  g_batch.points.clear();
+  g_batch.rects.clear();
+  g_batch.line_points.clear();
+  g_batch.line_counts.clear();
+  return result;
+}
+
+void SDLEx_BeginBatch(void)
+{
+  ++g_batch.depth;
+}
+
+int SDLEx_FlushBatch(void)
+{
+  return batch_flush();
+}
+
+int SDLEx_EndBatch(void)
+{
+  if (g_batch.depth > 0)
+    --g_batch.depth;
+  return g_batch.depth == 0 ? batch_flush() : 0;
+}
+
+void SDLEx_BatchBegin(SDL_Renderer * renderer)
+{
+  SDL_Color c;
+  SDL_BlendMode mode;
+  SDL_GetRenderDrawColor(renderer, &c.r, &c.g, &c.b, &c.a);
+  SDL_GetRenderDrawBlendMode(renderer, &mode);
+  if (renderer != g_batch.renderer || mode != g_batch.mode ||
+      c.r != g_batch.color.r || c.g != g_batch.color.g ||
+      c.b != g_batch.color.b || c.a != g_batch.color.a) {
+    batch_flush();
+    g_batch.renderer = renderer;
+    g_batch.color = c;
+    g_batch.mode = mode;
+  }
+  ++g_batch.depth;
+}
+
+int SDLEx_BatchSync(SDL_Renderer *)
+{
+  // cheap when nothing is pending, i.e. outside of the batched mode
+  return batch_flush();
+}
+
+int SDLEx_BatchEnd(SDL_Renderer *)
+{
+  if (g_batch.depth > 0)
+    --g_batch.depth;
+  return g_batch.depth == 0 ? batch_flush() : 0;
+}
+
+int SDLEx_BatchPoint(SDL_Renderer *, int x, int y)
+{
+  SDL_Point p = { x, y };
+  g_batch.points.push_back(p);
+  return 0;
+}
+
+int SDLEx_BatchFillRect(SDL_Renderer *, int x, int y, int w, int h)
+{
+  SDL_Rect r = { x, y, w, h };
+  g_batch.rects.push_back(r);
+  return 0;
+}
+
+int SDLEx_BatchLine(SDL_Renderer * renderer, int x1, int y1, int x2, int y2)
+{
+  int tmp;
+  if (x1 != x2 && y1 != y2) {
+    SDL_Point line[2] = { { x1, y1 }, { x2, y2 } };
+    return SDLEx_BatchLines(renderer, line, 2);
+  }
+  if (x1 > x2) { tmp = x1; x1 = x2; x2 = tmp; }
+  if (y1 > y2) { tmp = y1; y1 = y2; y2 = tmp; }
+  return SDLEx_BatchFillRect(renderer, x1, y1, x2 - x1 + 1, y2 - y1 + 1);
+}
+
+int SDLEx_BatchLines(SDL_Renderer *, const SDL_Point * points, int n)
+{
+  if (n < 2)
+    return 0;
+  g_batch.line_points.insert(g_batch.line_points.end(), points, points + n);
+  g_batch.line_counts.push_back(n);
+  return 0;
+}
+
+int SDLEx_BatchDrawPoint(SDL_Renderer * renderer, int x, int y)
+{
+  SDLEx_BatchBegin(renderer);
+  SDLEx_BatchPoint(renderer, x, y);
+  return SDLEx_BatchEnd(renderer);
+}
+
+int SDLEx_BatchDrawLine(SDL_Renderer * renderer, int x1, int y1, int x2, int y2)
+{
+  SDLEx_BatchBegin(renderer);
+  SDLEx_BatchLine(renderer, x1, y1, x2, y2);
+  return SDLEx_BatchEnd(renderer);
+}
@@ -0,0 +1,71 @@
+#ifndef _SDLEX_BATCH_H_
+#define _SDLEX_BATCH_H_
+
+#include "sdl_ex.h"
+
+/*
+ * Batching of the points and lines of the rasterizers.
+ * A primitive collects its pixels between SDLEx_BatchBegin and SDLEx_BatchEnd
+ * and they are flushed with one SDL_RenderDrawPoints and one SDL_RenderFillRects
+ * call when it ends, or when SDLEx_EndBatch is called in the batched mode.
+ * Pending pixels keep the draw color and blend mode they were added with.
+ */
+
+/*!
+\brief Start collecting a primitive, pending pixels of other renderer or color are flushed.
+*/
+void SDLEx_BatchBegin(SDL_Renderer * renderer);
+
+/*!
+\brief End a primitive, flush unless nested or in the batched mode.
+
+\returns Returns 0 on success, -1 on failure.
+*/
+int SDLEx_BatchEnd(SDL_Renderer * renderer);
+
+/*!
+\brief Add a point to the current primitive.
+
+\returns Returns 0.
+*/
+int SDLEx_BatchPoint(SDL_Renderer * renderer, int x, int y);
+
+/*!
+\brief Add a horizontal or vertical line to the current primitive, end points included.
+Other lines are added as a polyline of two points.
+
+\returns Returns 0.
+*/
+int SDLEx_BatchLine(SDL_Renderer * renderer, int x1, int y1, int x2, int y2);
+
+/*!
+\brief Add a filled rectangle to the current primitive.
+
+\returns Returns 0.
+*/
+int SDLEx_BatchFillRect(SDL_Renderer * renderer, int x, int y, int w, int h);
+
+/*!
+\brief Add a polyline to the current primitive, it is drawn with SDL_RenderDrawLines.
+
+\returns Returns 0.
+*/
+int SDLEx_BatchLines(SDL_Renderer * renderer, const SDL_Point * points, int n);
+
+/*!
+\brief Draw a single point or line of a primitive through the batch.
+
+\returns Returns 0 on success, -1 on failure.
+*/
+int SDLEx_BatchDrawPoint(SDL_Renderer * renderer, int x, int y);
+int SDLEx_BatchDrawLine(SDL_Renderer * renderer, int x1, int y1, int x2, int y2);
+
+/*!
+\brief Flush pending pixels before a draw which does not go through the batch,
+so draws keep their order in the batched mode.
+
+\returns Returns 0 on success, -1 on failure.
+*/
+int SDLEx_BatchSync(SDL_Renderer * renderer);
+
+#endif //_SDLEX_BATCH_H_
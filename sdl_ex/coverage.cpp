@@ -0,0 +1,204 @@
+#include "coverage.h"
+#include "batch.h"
+#include <string.h>
+#include <map>
+#include <vector>
+
+/*
+ * Cached coverage textures of the anti-aliased primitives.
+ * Textures belong to a renderer, so it is a part of the key with
+ * the translation independent shape parameters.
+ */
+
+struct coverage_key {
+  SDL_Renderer * renderer;
+  std::vector<int> params;
+
+  bool operator<(const coverage_key & o) const
+  {
+    if (renderer != o.renderer) return renderer < o.renderer;
+    return params < o.params;
+  }
+};
+
+struct coverage_entry {
+  SDL_Texture * texture;
+  // bounds relative to the anchor point
+  int x, y;
+  int w, h;
+};
+
+typedef std::map<coverage_key, coverage_entry> coverage_cache;
+
+// renderers are used from the main thread only, as SDL requires
+static coverage_cache g_coverage;
+static size_t g_coverage_texels = 0;
+static coverage_key g_lookup;
+static std::vector<uint8_t> g_alpha;
+static std::vector<uint32_t> g_pixels;
+
+// forget all textures when this many are cached
+static const size_t max_cached_shapes = 256;
+static const size_t max_cached_texels = 1 << 24;
+// larger shapes are clipped to the viewport and not cached
+static const size_t max_shape_texels = 1 << 22;
+
+void SDLEx_ClearCoverageCache(void)
+{
+  coverage_cache::iterator it = g_coverage.begin();
+  for (; it != g_coverage.end(); ++it)
+    SDL_DestroyTexture(it->second.texture);
+  g_coverage.clear();
+  g_coverage_texels = 0;
+}
+
+static int coverage_rasterize(SDLEx_Coverage & cov, SDLEx_CoverageRasterizer raster, const void * shape)
+{
+  size_t n = (size_t)cov.w * cov.h;
+  if (g_alpha.size() < n)
+    g_alpha.resize(n);
+  memset(&g_alpha[0], 0, n);
+  cov.alpha = &g_alpha[0];
+  return raster(&cov, shape);
+}
+
+/* white texture with the coverage as alpha, NULL if the renderer can not have it */
+static SDL_Texture * coverage_upload(SDL_Renderer * renderer, const SDLEx_Coverage & cov)
+{
+  SDL_RendererInfo info;
+  if (SDL_GetRendererInfo(renderer, &info) != 0)
+    return NULL;
+  if ((info.max_texture_width > 0 && cov.w > info.max_texture_width) ||
+      (info.max_texture_height > 0 && cov.h > info.max_texture_height))
+    return NULL;
+
+  SDL_Texture * texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+    SDL_TEXTUREACCESS_STATIC, cov.w, cov.h);
+  if (texture == NULL)
+    return NULL;
+
+  size_t n = (size_t)cov.w * cov.h;
+  if (g_pixels.size() < n)
+    g_pixels.resize(n);
+  for (size_t i = 0; i < n; ++i)
+    g_pixels[i] = ((uint32_t)cov.alpha[i] << 24) | 0x00ffffff;
+  if (SDL_UpdateTexture(texture, NULL, &g_pixels[0], cov.w * sizeof(uint32_t)) != 0) {
+    SDL_DestroyTexture(texture);
+    return NULL;
+  }
+#if SDL_VERSION_ATLEAST(2, 0, 12)
+  // scaled renderers magnify coverage like they do points
+  SDL_SetTextureScaleMode(texture, SDL_ScaleModeNearest);
+#endif
+  return texture;
+}
+
+static int coverage_blit(SDL_Renderer * renderer, SDL_Texture * texture, int x, int y, int w, int h)
+{
+  uint8_t r, g, b, a;
+  SDL_BlendMode mode;
+  int result = 0;
+  result |= SDL_GetRenderDrawColor(renderer, &r, &g, &b, &a);
+  result |= SDL_GetRenderDrawBlendMode(renderer, &mode);
+  if (result != 0)
+    return -1;
+  // weighted points are blended even if the renderer is not
+  if (mode == SDL_BLENDMODE_NONE)
+    mode = SDL_BLENDMODE_BLEND;
+
+  SDL_Rect dst = { x, y, w, h };
+  result |= SDLEx_BatchSync(renderer);
+  result |= SDL_SetTextureColorMod(texture, r, g, b);
+  result |= SDL_SetTextureAlphaMod(texture, a);
+  result |= SDL_SetTextureBlendMode(texture, mode);
+  result |= SDL_RenderCopy(renderer, texture, NULL, &dst);
+  return result;
+}
+
+/* draw buffer point by point when there is no texture for it */
+static int coverage_points(SDL_Renderer * renderer, const SDLEx_Coverage & cov)
+{
+  int result = 0;
+  for (int j = 0; j < cov.h; ++j) {
+    const uint8_t * row = cov.alpha + j * cov.w;
+    for (int i = 0; i < cov.w; ++i) {
+      // back to the 0..256 weight scale
+      if (row[i] != 0)
+        result |= SDLEx_RenderDrawPointWeight(renderer, cov.x + i, cov.y + j, (row[i] * 257) >> 8);
+    }
+  }
+  return result;
+}
+
+/* shape too large to cache, only its visible part is rasterized */
+static int coverage_render_clipped(SDL_Renderer * renderer, SDLEx_Coverage & cov,
+  SDLEx_CoverageRasterizer raster, const void * shape)
+{
+  SDL_Rect view, bounds, visible;
+  SDL_RenderGetViewport(renderer, &view);
+  view.x = view.y = 0;
+  if (SDL_RenderIsClipEnabled(renderer)) {
+    SDL_Rect clip;
+    SDL_RenderGetClipRect(renderer, &clip);
+    SDL_IntersectRect(&view, &clip, &view);
+  }
+  bounds.x = cov.x; bounds.y = cov.y;
+  bounds.w = cov.w; bounds.h = cov.h;
+  if (!SDL_IntersectRect(&view, &bounds, &visible))
+    return 0;
+
+  cov.x = visible.x; cov.y = visible.y;
+  cov.w = visible.w; cov.h = visible.h;
+  int result = coverage_rasterize(cov, raster, shape);
+  SDL_Texture * texture = coverage_upload(renderer, cov);
+  if (texture == NULL)
+    return result | coverage_points(renderer, cov);
+  result |= coverage_blit(renderer, texture, cov.x, cov.y, cov.w, cov.h);
+  SDL_DestroyTexture(texture);
+  return result;
+}
+
+int SDLEx_RenderCoverage(SDL_Renderer * renderer, const int * key, int key_len,
+  int x, int y, SDLEx_CoverageRasterizer raster, const void * shape)
+{
+  if (renderer == NULL)
+    return -1;
+
+  g_lookup.renderer = renderer;
+  g_lookup.params.assign(key, key + key_len);
+  coverage_cache::iterator it = g_coverage.find(g_lookup);
+  if (it != g_coverage.end()) {
+    const coverage_entry & e = it->second;
+    return coverage_blit(renderer, e.texture, x + e.x, y + e.y, e.w, e.h);
+  }
+
+  // measure first, then plot again into the buffer
+  SDLEx_Coverage cov;
+  cov.x = cov.y = 0;
+  cov.w = cov.h = 0;
+  cov.alpha = NULL;
+  int result = raster(&cov, shape);
+  if (cov.w == 0)
+    return result;
+  if ((size_t)cov.w * cov.h > max_shape_texels)
+    return result | coverage_render_clipped(renderer, cov, raster, shape);
+
+  result |= coverage_rasterize(cov, raster, shape);
+  SDL_Texture * texture = coverage_upload(renderer, cov);
+  if (texture == NULL)
+    return result | coverage_points(renderer, cov);
+
+  size_t texels = (size_t)cov.w * cov.h;
+  if (g_coverage.size() >= max_cached_shapes ||
+      g_coverage_texels + texels > max_cached_texels)
+    SDLEx_ClearCoverageCache();
+  coverage_entry & e = g_coverage[g_lookup];
+  e.texture = texture;
+  e.x = cov.x - x;
+  e.y = cov.y - y;
+  e.w = cov.w;
+  e.h = cov.h;
+  g_coverage_texels += texels;
+
+  return result | coverage_blit(renderer, texture, cov.x, cov.y, cov.w, cov.h);
+}
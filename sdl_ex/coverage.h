@@ -0,0 +1,80 @@
+#ifndef _SDLEX_COVERAGE_H_
+#define _SDLEX_COVERAGE_H_
+
+#include "sdl_ex.h"
+
+/*
+ * Coverage rasterization of the anti-aliased primitives.
+ * Shapes write per pixel weights into an alpha buffer which is uploaded
+ * once into a white texture. The texture is cached by the shape parameters
+ * that do not depend on its position, so repeated draws are single blits
+ * tinted with the current draw color.
+ */
+
+/*!
+\brief Alpha buffer of a shape, bounds are in renderer coordinates.
+Bounds grow to fit plotted pixels while the buffer is not allocated yet.
+*/
+typedef struct {
+	int x, y;
+	int w, h;
+	uint8_t * alpha;
+} SDLEx_Coverage;
+
+/*!
+\brief Callback plotting the weights of a shape.
+It runs twice on a cache miss, first to measure the bounds and then
+to fill the cleared buffer, so it must plot the same pixels both times.
+*/
+typedef int (*SDLEx_CoverageRasterizer)(SDLEx_Coverage * cov, const void * shape);
+
+/*!
+\brief Add weight of a pixel, overlapping weights are combined like blended points.
+
+Weights have the scale of SDLEx_RenderDrawPointWeight, 256 is full coverage.
+
+\returns Returns 0, to chain results like the drawing calls do.
+*/
+static inline int SDLEx_CoveragePlot(SDLEx_Coverage * cov, int x, int y, uint32_t weight)
+{
+	if (cov->alpha == NULL) {
+		if (cov->w == 0) {
+			cov->x = x; cov->y = y;
+			cov->w = cov->h = 1;
+			return 0;
+		}
+		if (x < cov->x) { cov->w += cov->x - x; cov->x = x; }
+		if (y < cov->y) { cov->h += cov->y - y; cov->y = y; }
+		if (x >= cov->x + cov->w) cov->w = x - cov->x + 1;
+		if (y >= cov->y + cov->h) cov->h = y - cov->y + 1;
+		return 0;
+	}
+	x -= cov->x;
+	y -= cov->y;
+	if (x < 0 || y < 0 || x >= cov->w || y >= cov->h)
+		return 0;
+	weight = (weight * 255) >> 8;
+	if (weight > 255)
+		weight = 255;
+	uint8_t * p = cov->alpha + y * cov->w + x;
+	*p = (uint8_t)(*p + ((weight * (255 - *p)) / 255));
+	return 0;
+}
+
+/*!
+\brief Draw a shape through its cached coverage texture.
+
+\param renderer The renderer to draw on.
+\param key Shape parameters relative to the anchor point.
+\param key_len Number of parameters in the key.
+\param x X coordinate of the anchor point the shape is rasterized around.
+\param y Y coordinate of the anchor point the shape is rasterized around.
+\param raster Callback rasterizing the shape on a cache miss.
+\param shape Data passed to the callback.
+
+\returns Returns 0 on success, -1 on failure.
+*/
+int SDLEx_RenderCoverage(SDL_Renderer * renderer, const int * key, int key_len,
+	int x, int y, SDLEx_CoverageRasterizer raster, const void * shape);
+
+#endif //_SDLEX_COVERAGE_H_
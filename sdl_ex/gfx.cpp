@@ -31,8 +31,12 @@ Andreas Schiffler -- aschiffler at ferzkopp dot net
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#include <vector>
 
 #include <sdl_ex.h>
+#include "coverage.h"
+#include "batch.h"
+#include "polygon.h"
 
 /* ---- Structures */
 
@@ -57,6 +61,23 @@ typedef struct {
 	int last1x, last1y, last2x, last2y, first1x, first1y, first2x, first2y, tempx, tempy;
 } SDL2_gfxMurphyIterator;
 
+/*!
+\brief Shapes with cached coverage, first value of a coverage key.
+*/
+typedef enum {
+	SDL2_gfxCoverageLine = 0,
+	SDL2_gfxCoverageEllipse = 1,
+	SDL2_gfxCoveragePolygon = 2
+} SDL2_gfxCoverageShape;
+
+/*!
+\brief The structure passed to the polygon coverage rasterizer.
+*/
+typedef struct {
+	const int *vx, *vy;
+	int n;
+} SDL2_gfxPolygonShape;
+
 int SDLEx_RenderDrawRect(SDL_Renderer * renderer, int x1, int y1, int x2, int y2)
 {
   SDL_Rect rect = {
@@ -64,6 +85,7 @@ int SDLEx_RenderDrawRect(SDL_Renderer * renderer, int x1, int y1, int x2, int y2
     x2 - x1,
     y2 - y1
   };
+  SDLEx_BatchSync(renderer);
   return SDL_RenderDrawRect(renderer, &rect);
 }
 
@@ -83,6 +105,7 @@ int SDLEx_RenderDrawPointWeight(SDL_Renderer* renderer, int x, int y, uint32_t w
 		amod = (uint8_t)(ax & 0x000000ff);
 	}
   
+  result |= SDLEx_BatchSync(renderer);
   result |= SDL_SetRenderDrawColor(renderer, r, g, b, amod);
   result |= SDL_RenderDrawPoint(renderer, x, y);
   result |= SDL_SetRenderDrawColor(renderer, r, g, b, a);
@@ -142,13 +165,13 @@ int SDLEx_RenderDrawRoundedRect(SDL_Renderer * renderer, int x1, int y1, int x2,
 	*/
 	if (x1 == x2) {
 		if (y1 == y2) {
-			return (SDL_RenderDrawPoint(renderer, x1, y1));
+			return (SDLEx_BatchDrawPoint(renderer, x1, y1));
 		} else {
-			return (SDL_RenderDrawLine(renderer, x1, y1, x1, y2));
+			return (SDLEx_BatchDrawLine(renderer, x1, y1, x1, y2));
 		}
 	} else {
 		if (y1 == y2) {
-			return (SDL_RenderDrawLine(renderer, x1, y1, x2, y1));
+			return (SDLEx_BatchDrawLine(renderer, x1, y1, x2, y1));
 		}
 	}
 
@@ -188,6 +211,8 @@ int SDLEx_RenderDrawRoundedRect(SDL_Renderer * renderer, int x1, int y1, int x2,
 		rad = h / 2;
 	}
 
+	SDLEx_BatchBegin(renderer);
+
 	/*
 	* Draw corners
 	*/
@@ -204,14 +229,16 @@ int SDLEx_RenderDrawRoundedRect(SDL_Renderer * renderer, int x1, int y1, int x2,
 	* Draw lines
 	*/
 	if (xx1 <= xx2) {
-		result |= SDL_RenderDrawLine(renderer, xx1, y1, xx2, y1);
-		result |= SDL_RenderDrawLine(renderer, xx1, y2, xx2, y2);
+		result |= SDLEx_BatchLine(renderer, xx1, y1, xx2, y1);
+		result |= SDLEx_BatchLine(renderer, xx1, y2, xx2, y2);
 	}
 	if (yy1 <= yy2) {
-		result |= SDL_RenderDrawLine(renderer, x1, yy1, x1, yy2);
-		result |= SDL_RenderDrawLine(renderer, x2, yy1, x2, yy2);
+		result |= SDLEx_BatchLine(renderer, x1, yy1, x1, yy2);
+		result |= SDLEx_BatchLine(renderer, x2, yy1, x2, yy2);
 	}
 
+	result |= SDLEx_BatchEnd(renderer);
+
 	return result;
 }
 
@@ -248,6 +275,13 @@ int SDLEx_RenderFillRoundedRect(SDL_Renderer * renderer, int x1, int y1, int x2,
 	int ypcy, ymcy, ypcx, ymcx;
 	int x, y, dx, dy;
 
+	/*
+	* Tessellated backend
+	*/
+	if (SDLEx_GetFillBackend() == SDLEX_FILL_MESH) {
+		return SDLEx_RenderFillRoundedRectMesh(renderer, x1, y1, x2, y2, rad);
+	}
+
 	/* 
 	* Check destination renderer 
 	*/
@@ -275,13 +309,13 @@ int SDLEx_RenderFillRoundedRect(SDL_Renderer * renderer, int x1, int y1, int x2,
 	*/
 	if (x1 == x2) {
 		if (y1 == y2) {
-			return (SDL_RenderDrawPoint(renderer, x1, y1));
+			return (SDLEx_BatchDrawPoint(renderer, x1, y1));
 		} else {
-			return (SDL_RenderDrawLine(renderer, x1, y1, x1, y2));
+			return (SDLEx_BatchDrawLine(renderer, x1, y1, x1, y2));
 		}
 	} else {
 		if (y1 == y2) {
-			return (SDL_RenderDrawLine(renderer, x1, y1, x2, y1));
+			return (SDLEx_BatchDrawLine(renderer, x1, y1, x2, y1));
 		}
 	}
 
@@ -329,6 +363,8 @@ int SDLEx_RenderFillRoundedRect(SDL_Renderer * renderer, int x1, int y1, int x2,
 	dx = x2 - x1 - rad - rad;
 	dy = y2 - y1 - rad - rad;
 
+	SDLEx_BatchBegin(renderer);
+
 	/*
 	* Draw corners
 	*/
@@ -341,10 +377,10 @@ int SDLEx_RenderFillRoundedRect(SDL_Renderer * renderer, int x1, int y1, int x2,
 			if (cy > 0) {
 				ypcy = y + cy;
 				ymcy = y - cy;
-				result |= SDL_RenderDrawLine(renderer, xmcx, ypcy + dy, xpcx + dx, ypcy + dy);
-				result |= SDL_RenderDrawLine(renderer, xmcx, ymcy, xpcx + dx, ymcy);
+				result |= SDLEx_BatchLine(renderer, xmcx, ypcy + dy, xpcx + dx, ypcy + dy);
+				result |= SDLEx_BatchLine(renderer, xmcx, ymcy, xpcx + dx, ymcy);
 			} else {
-				result |= SDL_RenderDrawLine(renderer, xmcx, y, xpcx + dx, y);
+				result |= SDLEx_BatchLine(renderer, xmcx, y, xpcx + dx, y);
 			}
 			ocy = cy;
 		}
@@ -353,10 +389,10 @@ int SDLEx_RenderFillRoundedRect(SDL_Renderer * renderer, int x1, int y1, int x2,
 				if (cx > 0) {
 					ypcx = y + cx;
 					ymcx = y - cx;
-					result |= SDL_RenderDrawLine(renderer, xmcy, ymcx, xpcy + dx, ymcx);
-					result |= SDL_RenderDrawLine(renderer, xmcy, ypcx + dy, xpcy + dx, ypcx + dy);
+					result |= SDLEx_BatchLine(renderer, xmcy, ymcx, xpcy + dx, ymcx);
+					result |= SDLEx_BatchLine(renderer, xmcy, ypcx + dy, xpcy + dx, ypcx + dy);
 				} else {
-					result |= SDL_RenderDrawLine(renderer, xmcy, y, xpcy + dx, y);
+					result |= SDLEx_BatchLine(renderer, xmcy, y, xpcy + dx, y);
 				}
 			}
 			ocx = cx;
@@ -380,9 +416,11 @@ int SDLEx_RenderFillRoundedRect(SDL_Renderer * renderer, int x1, int y1, int x2,
 
 	/* Inside */
 	if (dx > 0 && dy > 0) {
-    result |= SDLEx_RenderFillRect(renderer, x1, y1 + rad + 1, x2, y2 - rad);
+		result |= SDLEx_BatchFillRect(renderer, x1, y1 + rad + 1, x2 - x1 + 1, y2 - y1 - rad - rad);
 	}
 
+	result |= SDLEx_BatchEnd(renderer);
+
 	return (result);
 }
 
@@ -404,6 +442,11 @@ int SDLEx_RenderFillRect(SDL_Renderer * renderer, int x1, int y1, int x2, int y2
 	int tmp;
 	SDL_Rect rect;
 
+	/*
+	* Pending batched pixels are drawn first 
+	*/
+	SDLEx_BatchSync(renderer);
+
 	/*
 	* Test for special cases of straight lines or single point 
 	*/
@@ -459,7 +502,33 @@ int SDLEx_RenderFillRect(SDL_Renderer * renderer, int x1, int y1, int x2, int y2
 #define AAbits 8
 
 /*!
-\brief Internal function to draw anti-aliased line with alpha blending and endpoint control.
+\brief Internal function to plot a horizontal, vertical or diagonal line with full coverage.
+
+\param cov The coverage to plot into.
+\param x1 X coordinate of the first point of the line.
+\param y1 Y coordinate of the first point of the line.
+\param x2 X coordinate of the second point of the line.
+\param y2 Y coordinate of the second point of the line.
+
+\returns Returns 0.
+*/
+static int RasterizeSolidLine(SDLEx_Coverage * cov, int x1, int y1, int x2, int y2)
+{
+	int xdir, ydir;
+
+	xdir = (x2 > x1) - (x2 < x1);
+	ydir = (y2 > y1) - (y2 < y1);
+	SDLEx_CoveragePlot(cov, x1, y1, 256);
+	while ((x1 != x2) || (y1 != y2)) {
+		x1 += xdir;
+		y1 += ydir;
+		SDLEx_CoveragePlot(cov, x1, y1, 256);
+	}
+	return 0;
+}
+
+/*!
+\brief Internal function to rasterize anti-aliased line coverage with endpoint control.
 
 This implementation of the Wu antialiasing code is based on Mike Abrash's
 DDJ article which was reprinted as Chapter 42 of his Graphics Programming
@@ -468,20 +537,16 @@ fixed-point arithmetic by A. Schiffler. The endpoint control allows the
 supression to draw the last pixel useful for rendering continous aa-lines
 with alpha<255.
 
-\param renderer The renderer to draw on.
+\param cov The coverage to plot into.
 \param x1 X coordinate of the first point of the aa-line.
 \param y1 Y coordinate of the first point of the aa-line.
 \param x2 X coordinate of the second point of the aa-line.
 \param y2 Y coordinate of the second point of the aa-line.
-\param r The red value of the aa-line to draw. 
-\param g The green value of the aa-line to draw. 
-\param b The blue value of the aa-line to draw. 
-\param a The alpha value of the aa-line to draw.
 \param draw_endpoint Flag indicating if the endpoint should be drawn; draw if non-zero.
 
 \returns Returns 0 on success, -1 on failure.
 */
-int RenderDrawLine(SDL_Renderer * renderer, int x1, int y1, int x2, int y2, SDL_bool draw_endpoint)
+static int RasterizeLine(SDLEx_Coverage * cov, int x1, int y1, int x2, int y2, SDL_bool draw_endpoint)
 {
 	int xx0, yy0, xx1, yy1;
 	int result;
@@ -534,12 +599,12 @@ int RenderDrawLine(SDL_Renderer * renderer, int x1, int y1, int x2, int y2, SDL_
 		*/
 		if (draw_endpoint)
 		{
-			return (SDL_RenderDrawLine(renderer, x1, y1, x1, y2));
+			return (RasterizeSolidLine(cov, x1, y1, x1, y2));
 		} else {
 			if (dy > 0) {
-				return (SDL_RenderDrawLine(renderer, x1, yy0, x1, yy0+dy));
+				return (RasterizeSolidLine(cov, x1, yy0, x1, yy0+dy));
 			} else {
-				return (SDL_RenderDrawPoint(renderer, x1, y1));
+				return (SDLEx_CoveragePlot(cov, x1, y1, 256));
 			}
 		}
 	} else if (dy == 0) {
@@ -548,19 +613,19 @@ int RenderDrawLine(SDL_Renderer * renderer, int x1, int y1, int x2, int y2, SDL_
 		*/
 		if (draw_endpoint)
 		{
-			return (SDL_RenderDrawLine(renderer, x1, y1, x2, y1));
+			return (RasterizeSolidLine(cov, x1, y1, x2, y1));
 		} else {
 			if (dx > 0) {
-				return (SDL_RenderDrawLine(renderer, xx0, y1, xx0+dx, y1));
+				return (RasterizeSolidLine(cov, xx0, y1, xx0+dx, y1));
 			} else {
-				return (SDL_RenderDrawPoint(renderer, x1, y1));
+				return (SDLEx_CoveragePlot(cov, x1, y1, 256));
 			}
 		}
 	} else if ((dx == dy) && (draw_endpoint)) {
 		/*
 		* Diagonal line (with endpoint)
 		*/
-		return (SDL_RenderDrawLine(renderer, x1, y1, x2, y2));
+		return (RasterizeSolidLine(cov, x1, y1, x2, y2));
 	}
 
 
@@ -587,7 +652,7 @@ int RenderDrawLine(SDL_Renderer * renderer, int x1, int y1, int x2, int y2, SDL_
 	/*
 	* Draw the initial pixel in the foreground color 
 	*/
-	result |= SDL_RenderDrawPoint(renderer, x1, y1);
+	result |= SDLEx_CoveragePlot(cov, x1, y1, 256);
 
 	/*
 	* x-major or y-major? 
@@ -626,8 +691,8 @@ int RenderDrawLine(SDL_Renderer * renderer, int x1, int y1, int x2, int y2, SDL_
 			* the paired pixel. 
 			*/
 			wgt = (erracc >> intshift) & 255;
-      result |= SDLEx_RenderDrawPointWeight (renderer, xx0, yy0, 255 - wgt);
-			result |= SDLEx_RenderDrawPointWeight (renderer, x0pxdir, yy0, wgt);
+			result |= SDLEx_CoveragePlot(cov, xx0, yy0, 255 - wgt);
+			result |= SDLEx_CoveragePlot(cov, x0pxdir, yy0, wgt);
 		}
 
 	} else {
@@ -664,8 +729,8 @@ int RenderDrawLine(SDL_Renderer * renderer, int x1, int y1, int x2, int y2, SDL_
 			* the paired pixel. 
 			*/
 			wgt = (erracc >> intshift) & 255;
-			result |= SDLEx_RenderDrawPointWeight (renderer, xx0, yy0, 255 - wgt);
-			result |= SDLEx_RenderDrawPointWeight (renderer, xx0, y0p1, wgt);
+			result |= SDLEx_CoveragePlot(cov, xx0, yy0, 255 - wgt);
+			result |= SDLEx_CoveragePlot(cov, xx0, y0p1, wgt);
 		}
 	}
 
@@ -677,30 +742,55 @@ int RenderDrawLine(SDL_Renderer * renderer, int x1, int y1, int x2, int y2, SDL_
 		* Draw final pixel, always exactly intersected by the line and doesn't
 		* need to be weighted. 
 		*/
-		result |= SDL_RenderDrawPoint (renderer, x2, y2);
+		result |= SDLEx_CoveragePlot(cov, x2, y2, 256);
 	}
 
 	return (result);
 }
 
+static int RasterizeLineShape(SDLEx_Coverage * cov, const void * shape)
+{
+	const int * l = (const int *)shape;
+	return RasterizeLine(cov, l[0], l[1], l[2], l[3], SDL_TRUE);
+}
+
 /*!
 \brief Draw anti-aliased line with alpha blending.
 
+The line is drawn from its coverage texture, cached by the line direction.
+
 \param renderer The renderer to draw on.
 \param x1 X coordinate of the first point of the aa-line.
 \param y1 Y coordinate of the first point of the aa-line.
 \param x2 X coordinate of the second point of the aa-line.
 \param y2 Y coordinate of the second point of the aa-line.
-\param r The red value of the aa-line to draw. 
-\param g The green value of the aa-line to draw. 
-\param b The blue value of the aa-line to draw. 
-\param a The alpha value of the aa-line to draw.
 
 \returns Returns 0 on success, -1 on failure.
 */
 int SDLEx_RenderDrawLine(SDL_Renderer * renderer, int x1, int y1, int x2, int y2)
 {
-	return RenderDrawLine(renderer, x1, y1, x2, y2, SDL_TRUE);
+	int dx, dy;
+	int line[4];
+	int key[3];
+
+	/*
+	* Horizontal, vertical and diagonal lines have no weighted pixels 
+	*/
+	dx = x2 - x1;
+	dy = y2 - y1;
+	if ((dx == 0) || (dy == 0) || (abs(dx) == abs(dy))) {
+		SDLEx_BatchSync(renderer);
+		return (SDL_RenderDrawLine(renderer, x1, y1, x2, y2));
+	}
+
+	line[0] = x1;
+	line[1] = y1;
+	line[2] = x2;
+	line[3] = y2;
+	key[0] = SDL2_gfxCoverageLine;
+	key[1] = dx;
+	key[2] = dy;
+	return SDLEx_RenderCoverage(renderer, key, 3, x1, y1, RasterizeLineShape, line);
 }
 
 /* ----- Circle */
@@ -760,7 +850,7 @@ int SDLEx_RenderDrawArc(SDL_Renderer * renderer, int x, int y, int rad, int star
 	* Special case for rad=0 - draw a point 
 	*/
 	if (rad == 0) {
-		return (SDL_RenderDrawPoint(renderer, x, y));
+		return (SDLEx_BatchDrawPoint(renderer, x, y));
 	}
 
 	// Octant labelling
@@ -881,6 +971,8 @@ int SDLEx_RenderDrawArc(SDL_Renderer * renderer, int x, int y, int rad, int star
 
 	// so now we have what octants to draw and when to draw them. all that's left is the actual raster code.
 
+	SDLEx_BatchBegin(renderer);
+
 	/*
 	* Draw arc 
 	*/
@@ -892,13 +984,13 @@ int SDLEx_RenderDrawArc(SDL_Renderer * renderer, int x, int y, int rad, int star
 			xmcx = x - cx;
 
 			// always check if we're drawing a certain octant before adding a pixel to that octant.
-			if (drawoct & 4)  result |= SDL_RenderDrawPoint(renderer, xmcx, ypcy);
-			if (drawoct & 2)  result |= SDL_RenderDrawPoint(renderer, xpcx, ypcy);
-			if (drawoct & 32) result |= SDL_RenderDrawPoint(renderer, xmcx, ymcy);
-			if (drawoct & 64) result |= SDL_RenderDrawPoint(renderer, xpcx, ymcy);
+			if (drawoct & 4)  result |= SDLEx_BatchPoint(renderer, xmcx, ypcy);
+			if (drawoct & 2)  result |= SDLEx_BatchPoint(renderer, xpcx, ypcy);
+			if (drawoct & 32) result |= SDLEx_BatchPoint(renderer, xmcx, ymcy);
+			if (drawoct & 64) result |= SDLEx_BatchPoint(renderer, xpcx, ymcy);
 		} else {
-			if (drawoct & 96) result |= SDL_RenderDrawPoint(renderer, x, ymcy);
-			if (drawoct & 6)  result |= SDL_RenderDrawPoint(renderer, x, ypcy);
+			if (drawoct & 96) result |= SDLEx_BatchPoint(renderer, x, ymcy);
+			if (drawoct & 6)  result |= SDLEx_BatchPoint(renderer, x, ypcy);
 		}
 
 		xpcy = x + cy;
@@ -906,13 +998,13 @@ int SDLEx_RenderDrawArc(SDL_Renderer * renderer, int x, int y, int rad, int star
 		if (cx > 0 && cx != cy) {
 			ypcx = y + cx;
 			ymcx = y - cx;
-			if (drawoct & 8)   result |= SDL_RenderDrawPoint(renderer, xmcy, ypcx);
-			if (drawoct & 1)   result |= SDL_RenderDrawPoint(renderer, xpcy, ypcx);
-			if (drawoct & 16)  result |= SDL_RenderDrawPoint(renderer, xmcy, ymcx);
-			if (drawoct & 128) result |= SDL_RenderDrawPoint(renderer, xpcy, ymcx);
+			if (drawoct & 8)   result |= SDLEx_BatchPoint(renderer, xmcy, ypcx);
+			if (drawoct & 1)   result |= SDLEx_BatchPoint(renderer, xpcy, ypcx);
+			if (drawoct & 16)  result |= SDLEx_BatchPoint(renderer, xmcy, ymcx);
+			if (drawoct & 128) result |= SDLEx_BatchPoint(renderer, xpcy, ymcx);
 		} else if (cx == 0) {
-			if (drawoct & 24)  result |= SDL_RenderDrawPoint(renderer, xmcy, y);
-			if (drawoct & 129) result |= SDL_RenderDrawPoint(renderer, xpcy, y);
+			if (drawoct & 24)  result |= SDLEx_BatchPoint(renderer, xmcy, y);
+			if (drawoct & 129) result |= SDLEx_BatchPoint(renderer, xpcy, y);
 		}
 
 		/*
@@ -945,6 +1037,8 @@ int SDLEx_RenderDrawArc(SDL_Renderer * renderer, int x, int y, int rad, int star
 		cx++;
 	} while (cx <= cy);
 
+	result |= SDLEx_BatchEnd(renderer);
+
 	return (result);
 }
 
@@ -993,6 +1087,13 @@ int SDLEx_RenderFillCircle(SDL_Renderer * renderer, int x, int y, int rad)
 	int xpcx, xmcx, xpcy, xmcy;
 	int ypcy, ymcy, ypcx, ymcx;
 
+	/*
+	* Tessellated backend
+	*/
+	if (SDLEx_GetFillBackend() == SDLEX_FILL_MESH) {
+		return SDLEx_RenderFillCircleMesh(renderer, x, y, rad);
+	}
+
 	/*
 	* Sanity check radius 
 	*/
@@ -1004,9 +1105,11 @@ int SDLEx_RenderFillCircle(SDL_Renderer * renderer, int x, int y, int rad)
 	* Special case for rad=0 - draw a point 
 	*/
 	if (rad == 0) {
-		return (SDL_RenderDrawPoint(renderer, x, y));
+		return (SDLEx_BatchDrawPoint(renderer, x, y));
 	}
 
+	SDLEx_BatchBegin(renderer);
+
 	/*
 	* Draw 
 	*/
@@ -1019,10 +1122,10 @@ int SDLEx_RenderFillCircle(SDL_Renderer * renderer, int x, int y, int rad)
 			if (cy > 0) {
 				ypcy = y + cy;
 				ymcy = y - cy;
-				result |= SDL_RenderDrawLine(renderer, xmcx, ypcy, xpcx, ypcy);
-				result |= SDL_RenderDrawLine(renderer, xmcx, ymcy, xpcx, ymcy);
+				result |= SDLEx_BatchLine(renderer, xmcx, ypcy, xpcx, ypcy);
+				result |= SDLEx_BatchLine(renderer, xmcx, ymcy, xpcx, ymcy);
 			} else {
-				result |= SDL_RenderDrawLine(renderer, xmcx, y, xpcx, y);
+				result |= SDLEx_BatchLine(renderer, xmcx, y, xpcx, y);
 			}
 			ocy = cy;
 		}
@@ -1031,10 +1134,10 @@ int SDLEx_RenderFillCircle(SDL_Renderer * renderer, int x, int y, int rad)
 				if (cx > 0) {
 					ypcx = y + cx;
 					ymcx = y - cx;
-					result |= SDL_RenderDrawLine(renderer, xmcy, ymcx, xpcy, ymcx);
-					result |= SDL_RenderDrawLine(renderer, xmcy, ypcx, xpcy, ypcx);
+					result |= SDLEx_BatchLine(renderer, xmcy, ymcx, xpcy, ymcx);
+					result |= SDLEx_BatchLine(renderer, xmcy, ypcx, xpcy, ypcx);
 				} else {
-					result |= SDL_RenderDrawLine(renderer, xmcy, y, xpcy, y);
+					result |= SDLEx_BatchLine(renderer, xmcy, y, xpcy, y);
 				}
 			}
 			ocx = cx;
@@ -1056,6 +1159,8 @@ int SDLEx_RenderFillCircle(SDL_Renderer * renderer, int x, int y, int rad)
 		cx++;
 	} while (cx <= cy);
 
+	result |= SDLEx_BatchEnd(renderer);
+
 	return (result);
 }
 
@@ -1094,15 +1199,17 @@ int SDLEx_RenderDrawEllipse(SDL_Renderer * renderer, int x, int y, int rx, int r
 	* Special case for rx=0 - draw a vline 
 	*/
 	if (rx == 0) {
-		return (SDL_RenderDrawLine(renderer, x, y - ry, x, y + ry));
+		return (SDLEx_BatchDrawLine(renderer, x, y - ry, x, y + ry));
 	}
 	/*
 	* Special case for ry=0 - draw a hline 
 	*/
 	if (ry == 0) {
-		return (SDL_RenderDrawLine(renderer, x - rx, y, x + rx, y));
+		return (SDLEx_BatchDrawLine(renderer, x - rx, y, x + rx, y));
 	}
 
+	SDLEx_BatchBegin(renderer);
+
 	/*
 	* Init vars 
 	*/
@@ -1127,13 +1234,13 @@ int SDLEx_RenderDrawEllipse(SDL_Renderer * renderer, int x, int y, int rx, int r
 				if (k > 0) {
 					ypk = y + k;
 					ymk = y - k;
-					result |= SDL_RenderDrawPoint(renderer, xmh, ypk);
-					result |= SDL_RenderDrawPoint(renderer, xph, ypk);
-					result |= SDL_RenderDrawPoint(renderer, xmh, ymk);
-					result |= SDL_RenderDrawPoint(renderer, xph, ymk);
+					result |= SDLEx_BatchPoint(renderer, xmh, ypk);
+					result |= SDLEx_BatchPoint(renderer, xph, ypk);
+					result |= SDLEx_BatchPoint(renderer, xmh, ymk);
+					result |= SDLEx_BatchPoint(renderer, xph, ymk);
 				} else {
-					result |= SDL_RenderDrawPoint(renderer, xmh, y);
-					result |= SDL_RenderDrawPoint(renderer, xph, y);
+					result |= SDLEx_BatchPoint(renderer, xmh, y);
+					result |= SDLEx_BatchPoint(renderer, xph, y);
 				}
 				ok = k;
 				xpi = x + i;
@@ -1141,13 +1248,13 @@ int SDLEx_RenderDrawEllipse(SDL_Renderer * renderer, int x, int y, int rx, int r
 				if (j > 0) {
 					ypj = y + j;
 					ymj = y - j;
-					result |= SDL_RenderDrawPoint(renderer, xmi, ypj);
-					result |= SDL_RenderDrawPoint(renderer, xpi, ypj);
-					result |= SDL_RenderDrawPoint(renderer, xmi, ymj);
-					result |= SDL_RenderDrawPoint(renderer, xpi, ymj);
+					result |= SDLEx_BatchPoint(renderer, xmi, ypj);
+					result |= SDLEx_BatchPoint(renderer, xpi, ypj);
+					result |= SDLEx_BatchPoint(renderer, xmi, ymj);
+					result |= SDLEx_BatchPoint(renderer, xpi, ymj);
 				} else {
-					result |= SDL_RenderDrawPoint(renderer, xmi, y);
-					result |= SDL_RenderDrawPoint(renderer, xpi, y);
+					result |= SDLEx_BatchPoint(renderer, xmi, y);
+					result |= SDLEx_BatchPoint(renderer, xpi, y);
 				}
 				oj = j;
 			}
@@ -1172,13 +1279,13 @@ int SDLEx_RenderDrawEllipse(SDL_Renderer * renderer, int x, int y, int rx, int r
 				if (i > 0) {
 					ypi = y + i;
 					ymi = y - i;
-					result |= SDL_RenderDrawPoint(renderer, xmj, ypi);
-					result |= SDL_RenderDrawPoint(renderer, xpj, ypi);
-					result |= SDL_RenderDrawPoint(renderer, xmj, ymi);
-					result |= SDL_RenderDrawPoint(renderer, xpj, ymi);
+					result |= SDLEx_BatchPoint(renderer, xmj, ypi);
+					result |= SDLEx_BatchPoint(renderer, xpj, ypi);
+					result |= SDLEx_BatchPoint(renderer, xmj, ymi);
+					result |= SDLEx_BatchPoint(renderer, xpj, ymi);
 				} else {
-					result |= SDL_RenderDrawPoint(renderer, xmj, y);
-					result |= SDL_RenderDrawPoint(renderer, xpj, y);
+					result |= SDLEx_BatchPoint(renderer, xmj, y);
+					result |= SDLEx_BatchPoint(renderer, xpj, y);
 				}
 				oi = i;
 				xmk = x - k;
@@ -1186,13 +1293,13 @@ int SDLEx_RenderDrawEllipse(SDL_Renderer * renderer, int x, int y, int rx, int r
 				if (h > 0) {
 					yph = y + h;
 					ymh = y - h;
-					result |= SDL_RenderDrawPoint(renderer, xmk, yph);
-					result |= SDL_RenderDrawPoint(renderer, xpk, yph);
-					result |= SDL_RenderDrawPoint(renderer, xmk, ymh);
-					result |= SDL_RenderDrawPoint(renderer, xpk, ymh);
+					result |= SDLEx_BatchPoint(renderer, xmk, yph);
+					result |= SDLEx_BatchPoint(renderer, xpk, yph);
+					result |= SDLEx_BatchPoint(renderer, xmk, ymh);
+					result |= SDLEx_BatchPoint(renderer, xpk, ymh);
 				} else {
-					result |= SDL_RenderDrawPoint(renderer, xmk, y);
-					result |= SDL_RenderDrawPoint(renderer, xpk, y);
+					result |= SDLEx_BatchPoint(renderer, xmk, y);
+					result |= SDLEx_BatchPoint(renderer, xpk, y);
 				}
 				oh = h;
 			}
@@ -1203,6 +1310,8 @@ int SDLEx_RenderDrawEllipse(SDL_Renderer * renderer, int x, int y, int rx, int r
 		} while (i > h);
 	}
 
+	result |= SDLEx_BatchEnd(renderer);
+
 	return (result);
 }
 
@@ -1249,9 +1358,9 @@ __declspec(naked) long int
 #endif
 
 /*!
-\brief Draw anti-aliased ellipse with blending.
+\brief Internal function to rasterize anti-aliased ellipse coverage.
 
-\param renderer The renderer to draw on.
+\param cov The coverage to plot into.
 \param x X coordinate of the center of the aa-ellipse.
 \param y Y coordinate of the center of the aa-ellipse.
 \param rx Horizontal radius in pixels of the aa-ellipse.
@@ -1259,7 +1368,7 @@ __declspec(naked) long int
 
 \returns Returns 0 on success, -1 on failure.
 */
-int SDLEx_RenderDrawAAEllipse(SDL_Renderer * renderer, int x, int y, int rx, int ry)
+static int RasterizeEllipse(SDLEx_Coverage * cov, int x, int y, int rx, int ry)
 {
 	int result;
 	int i;
@@ -1269,26 +1378,6 @@ int SDLEx_RenderDrawAAEllipse(SDL_Renderer * renderer, int x, int y, int rx, int
 	double sab;
 	uint8_t weight, iweight;
 
-	/*
-	* Sanity check radii 
-	*/
-	if ((rx < 0) || (ry < 0)) {
-		return (-1);
-	}
-
-	/*
-	* Special case for rx=0 - draw a vline 
-	*/
-	if (rx == 0) {
-		return (SDL_RenderDrawLine(renderer, x, y - ry, x, y + ry));
-	}
-	/*
-	* Special case for ry=0 - draw an hline 
-	*/
-	if (ry == 0) {
-		return (SDL_RenderDrawLine(renderer, x - rx, y, x + rx, y));
-	}
-
 	/* Variable setup */
 	a2 = rx * rx;
 	b2 = ry * ry;
@@ -1314,10 +1403,10 @@ int SDLEx_RenderDrawAAEllipse(SDL_Renderer * renderer, int x, int y, int rx, int
 	result = 0;
 	
 	/* "End points" */
-	result |= SDL_RenderDrawPoint(renderer, xp, yp);
-	result |= SDL_RenderDrawPoint(renderer, xc2 - xp, yp);
-	result |= SDL_RenderDrawPoint(renderer, xp, yc2 - yp);
-	result |= SDL_RenderDrawPoint(renderer, xc2 - xp, yc2 - yp);
+	result |= SDLEx_CoveragePlot(cov, xp, yp, 256);
+	result |= SDLEx_CoveragePlot(cov, xc2 - xp, yp, 256);
+	result |= SDLEx_CoveragePlot(cov, xp, yc2 - yp, 256);
+	result |= SDLEx_CoveragePlot(cov, xc2 - xp, yc2 - yp, 256);
 
 	for (i = 1; i <= dxt; i++) {
 		xp--;
@@ -1359,20 +1448,20 @@ int SDLEx_RenderDrawAAEllipse(SDL_Renderer * renderer, int x, int y, int rx, int
 
 		/* Upper half */
 		xx = xc2 - xp;
-		result |= SDLEx_RenderDrawPointWeight(renderer, xp, yp, iweight);
-		result |= SDLEx_RenderDrawPointWeight(renderer, xx, yp, iweight);
+		result |= SDLEx_CoveragePlot(cov, xp, yp, iweight);
+		result |= SDLEx_CoveragePlot(cov, xx, yp, iweight);
 
-		result |= SDLEx_RenderDrawPointWeight(renderer, xp, ys, weight);
-		result |= SDLEx_RenderDrawPointWeight(renderer, xx, ys, weight);
+		result |= SDLEx_CoveragePlot(cov, xp, ys, weight);
+		result |= SDLEx_CoveragePlot(cov, xx, ys, weight);
 
 		/* Lower half */
 		yy = yc2 - yp;
-		result |= SDLEx_RenderDrawPointWeight(renderer, xp, yy, iweight);
-		result |= SDLEx_RenderDrawPointWeight(renderer, xx, yy, iweight);
+		result |= SDLEx_CoveragePlot(cov, xp, yy, iweight);
+		result |= SDLEx_CoveragePlot(cov, xx, yy, iweight);
 
 		yy = yc2 - ys;
-		result |= SDLEx_RenderDrawPointWeight(renderer, xp, yy, weight);
-		result |= SDLEx_RenderDrawPointWeight(renderer, xx, yy, weight);
+		result |= SDLEx_CoveragePlot(cov, xp, yy, weight);
+		result |= SDLEx_CoveragePlot(cov, xx, yy, weight);
 	}
 
 	/* Replaces original approximation code dyt = abs(yp - yc); */
@@ -1419,24 +1508,80 @@ int SDLEx_RenderDrawAAEllipse(SDL_Renderer * renderer, int x, int y, int rx, int
 		/* Left half */
 		xx = xc2 - xp;
 		yy = yc2 - yp;
-		result |= SDLEx_RenderDrawPointWeight(renderer, xp, yp, iweight);
-		result |= SDLEx_RenderDrawPointWeight(renderer, xx, yp, iweight);
+		result |= SDLEx_CoveragePlot(cov, xp, yp, iweight);
+		result |= SDLEx_CoveragePlot(cov, xx, yp, iweight);
 
-		result |= SDLEx_RenderDrawPointWeight(renderer, xp, yy, iweight);
-		result |= SDLEx_RenderDrawPointWeight(renderer, xx, yy, iweight);
+		result |= SDLEx_CoveragePlot(cov, xp, yy, iweight);
+		result |= SDLEx_CoveragePlot(cov, xx, yy, iweight);
 
 		/* Right half */
 		xx = xc2 - xs;
-		result |= SDLEx_RenderDrawPointWeight(renderer, xs, yp, weight);
-		result |= SDLEx_RenderDrawPointWeight(renderer, xx, yp, weight);
+		result |= SDLEx_CoveragePlot(cov, xs, yp, weight);
+		result |= SDLEx_CoveragePlot(cov, xx, yp, weight);
 
-		result |= SDLEx_RenderDrawPointWeight(renderer, xs, yy, weight);
-		result |= SDLEx_RenderDrawPointWeight(renderer, xx, yy, weight);		
+		result |= SDLEx_CoveragePlot(cov, xs, yy, weight);
+		result |= SDLEx_CoveragePlot(cov, xx, yy, weight);		
 	}
 
 	return (result);
 }
 
+static int RasterizeEllipseShape(SDLEx_Coverage * cov, const void * shape)
+{
+	const int * e = (const int *)shape;
+	return RasterizeEllipse(cov, e[0], e[1], e[2], e[3]);
+}
+
+/*!
+\brief Draw anti-aliased ellipse with blending.
+
+The ellipse is drawn from its coverage texture, cached by the radii.
+
+\param renderer The renderer to draw on.
+\param x X coordinate of the center of the aa-ellipse.
+\param y Y coordinate of the center of the aa-ellipse.
+\param rx Horizontal radius in pixels of the aa-ellipse.
+\param ry Vertical radius in pixels of the aa-ellipse.
+
+\returns Returns 0 on success, -1 on failure.
+*/
+int SDLEx_RenderDrawAAEllipse(SDL_Renderer * renderer, int x, int y, int rx, int ry)
+{
+	int ellipse[4];
+	int key[3];
+
+	/*
+	* Sanity check radii 
+	*/
+	if ((rx < 0) || (ry < 0)) {
+		return (-1);
+	}
+
+	/*
+	* Special case for rx=0 - draw a vline 
+	*/
+	if (rx == 0) {
+		SDLEx_BatchSync(renderer);
+		return (SDL_RenderDrawLine(renderer, x, y - ry, x, y + ry));
+	}
+	/*
+	* Special case for ry=0 - draw an hline 
+	*/
+	if (ry == 0) {
+		SDLEx_BatchSync(renderer);
+		return (SDL_RenderDrawLine(renderer, x - rx, y, x + rx, y));
+	}
+
+	ellipse[0] = x;
+	ellipse[1] = y;
+	ellipse[2] = rx;
+	ellipse[3] = ry;
+	key[0] = SDL2_gfxCoverageEllipse;
+	key[1] = rx;
+	key[2] = ry;
+	return SDLEx_RenderCoverage(renderer, key, 3, x, y, RasterizeEllipseShape, ellipse);
+}
+
 /* ---- Filled Ellipse */
 
 /*!
@@ -1461,6 +1606,13 @@ int SDLEx_RenderFillEllipse(SDL_Renderer * renderer, int x, int y, int rx, int r
 	int xmj, xpj;
 	int xmk, xpk;
 
+	/*
+	* Tessellated backend
+	*/
+	if (SDLEx_GetFillBackend() == SDLEX_FILL_MESH) {
+		return SDLEx_RenderFillEllipseMesh(renderer, x, y, rx, ry);
+	}
+
 	/*
 	* Sanity check radii 
 	*/
@@ -1472,15 +1624,17 @@ int SDLEx_RenderFillEllipse(SDL_Renderer * renderer, int x, int y, int rx, int r
 	* Special case for rx=0 - draw a vline 
 	*/
 	if (rx == 0) {
-		return (SDL_RenderDrawLine(renderer, x, y - ry, x, y + ry));
+		return (SDLEx_BatchDrawLine(renderer, x, y - ry, x, y + ry));
 	}
 	/*
 	* Special case for ry=0 - draw a hline 
 	*/
 	if (ry == 0) {
-		return (SDL_RenderDrawLine(renderer, x - rx, y, x + rx, y));
+		return (SDLEx_BatchDrawLine(renderer, x - rx, y, x + rx, y));
 	}
 
+	SDLEx_BatchBegin(renderer);
+
 	/*
 	* Init vars 
 	*/
@@ -1503,10 +1657,10 @@ int SDLEx_RenderFillEllipse(SDL_Renderer * renderer, int x, int y, int rx, int r
 				xph = x + h;
 				xmh = x - h;
 				if (k > 0) {
-					result |= SDL_RenderDrawLine(renderer, xmh, y + k, xph, y + k);
-					result |= SDL_RenderDrawLine(renderer, xmh, y - k, xph, y - k);
+					result |= SDLEx_BatchLine(renderer, xmh, y + k, xph, y + k);
+					result |= SDLEx_BatchLine(renderer, xmh, y - k, xph, y - k);
 				} else {
-					result |= SDL_RenderDrawLine(renderer, xmh, y, xph, y);
+					result |= SDLEx_BatchLine(renderer, xmh, y, xph, y);
 				}
 				ok = k;
 			}
@@ -1514,10 +1668,10 @@ int SDLEx_RenderFillEllipse(SDL_Renderer * renderer, int x, int y, int rx, int r
 				xmi = x - i;
 				xpi = x + i;
 				if (j > 0) {
-					result |= SDL_RenderDrawLine(renderer, xmi, y + j, xpi, y + j);
-					result |= SDL_RenderDrawLine(renderer, xmi, y - j, xpi, y - j);
+					result |= SDLEx_BatchLine(renderer, xmi, y + j, xpi, y + j);
+					result |= SDLEx_BatchLine(renderer, xmi, y - j, xpi, y - j);
 				} else {
-					result |= SDL_RenderDrawLine(renderer, xmi, y, xpi, y);
+					result |= SDLEx_BatchLine(renderer, xmi, y, xpi, y);
 				}
 				oj = j;
 			}
@@ -1540,10 +1694,10 @@ int SDLEx_RenderFillEllipse(SDL_Renderer * renderer, int x, int y, int rx, int r
 				xmj = x - j;
 				xpj = x + j;
 				if (i > 0) {
-					result |= SDL_RenderDrawLine(renderer, xmj, y + i, xpj, y + i);
-					result |= SDL_RenderDrawLine(renderer, xmj, y - i, xpj, y - i);
+					result |= SDLEx_BatchLine(renderer, xmj, y + i, xpj, y + i);
+					result |= SDLEx_BatchLine(renderer, xmj, y - i, xpj, y - i);
 				} else {
-					result |= SDL_RenderDrawLine(renderer, xmj, y, xpj, y);
+					result |= SDLEx_BatchLine(renderer, xmj, y, xpj, y);
 				}
 				oi = i;
 			}
@@ -1551,10 +1705,10 @@ int SDLEx_RenderFillEllipse(SDL_Renderer * renderer, int x, int y, int rx, int r
 				xmk = x - k;
 				xpk = x + k;
 				if (h > 0) {
-					result |= SDL_RenderDrawLine(renderer, xmk, y + h, xpk, y + h);
-					result |= SDL_RenderDrawLine(renderer, xmk, y - h, xpk, y - h);
+					result |= SDLEx_BatchLine(renderer, xmk, y + h, xpk, y + h);
+					result |= SDLEx_BatchLine(renderer, xmk, y - h, xpk, y - h);
 				} else {
-					result |= SDL_RenderDrawLine(renderer, xmk, y, xpk, y);
+					result |= SDLEx_BatchLine(renderer, xmk, y, xpk, y);
 				}
 				oh = h;
 			}
@@ -1565,6 +1719,8 @@ int SDLEx_RenderFillEllipse(SDL_Renderer * renderer, int x, int y, int rx, int r
 		} while (i > h);
 	}
 
+	result |= SDLEx_BatchEnd(renderer);
+
 	return (result);
 }
 
@@ -1612,6 +1768,7 @@ int RenderDrawPie(SDL_Renderer * renderer, int x, int y, int rad, int start, int
 	* Special case for rad=0 - draw a point 
 	*/
 	if (rad == 0) {
+		SDLEx_BatchSync(renderer);
 		return (SDL_RenderDrawPoint(renderer, x, y));
 	}
 
@@ -1637,7 +1794,7 @@ int RenderDrawPie(SDL_Renderer * renderer, int x, int y, int rad, int start, int
 	}
 
 	/* Allocate combined vertex array */
-	vx = vy = (int *) malloc(2 * sizeof(Uint16) * numpoints);
+	vx = vy = (int *) malloc(2 * sizeof(int) * numpoints);
 	if (vx == NULL) {
 		return (-1);
 	}
@@ -1656,6 +1813,7 @@ int RenderDrawPie(SDL_Renderer * renderer, int x, int y, int rad, int start, int
 
 	if (numpoints<3)
 	{
+		SDLEx_BatchSync(renderer);
 		result = SDL_RenderDrawLine(renderer, vx[0], vy[0], vx[1], vy[1]);
 	}
 	else
@@ -1727,6 +1885,9 @@ int SDLEx_RenderDrawPie(SDL_Renderer * renderer, int x, int y, int rad, int star
 */
 int SDLEx_RenderFillPie(SDL_Renderer * renderer, int x, int y, int rad, int start, int end)
 {
+	if (SDLEx_GetFillBackend() == SDLEX_FILL_MESH) {
+		return SDLEx_RenderFillPieMesh(renderer, x, y, rad, start, end);
+	}
 	return RenderDrawPie(renderer, x, y, rad, start, end, SDL_TRUE);
 }
 
@@ -1888,6 +2049,7 @@ int RenderDrawPolygon(SDL_Renderer * renderer, const int * vx, const int * vy, i
 	/*
 	* Draw 
 	*/
+	result |= SDLEx_BatchSync(renderer);
 	result |= SDL_RenderDrawLines(renderer, points, nn);
 	free(points);
 
@@ -1946,9 +2108,34 @@ int SDLEx_RenderDrawPolygon(SDL_Renderer * renderer, const int * vx, const int *
 
 /* ---- AA-Polygon */
 
+/*!
+\brief Internal function to rasterize anti-aliased polygon coverage.
+
+\param cov The coverage to plot into.
+\param shape The polygon, a SDL2_gfxPolygonShape.
+
+\returns Returns 0 on success, -1 on failure.
+*/
+static int RasterizePolygonShape(SDLEx_Coverage * cov, const void * shape)
+{
+	const SDL2_gfxPolygonShape *p = (const SDL2_gfxPolygonShape *)shape;
+	int result;
+	int i;
+
+	result = 0;
+	for (i = 1; i < p->n; i++) {
+		result |= RasterizeLine(cov, p->vx[i - 1], p->vy[i - 1], p->vx[i], p->vy[i], SDL_FALSE);
+	}
+	result |= RasterizeLine(cov, p->vx[p->n - 1], p->vy[p->n - 1], p->vx[0], p->vy[0], SDL_FALSE);
+	return (result);
+}
+
 /*!
 \brief Draw anti-aliased polygon with alpha blending.
 
+The polygon is drawn from its coverage texture, cached by the vertices
+relative to the first one.
+
 \param renderer The renderer to draw on.
 \param vx Vertex array containing X coordinates of the points of the aa-polygon.
 \param vy Vertex array containing Y coordinates of the points of the aa-polygon.
@@ -1958,9 +2145,9 @@ int SDLEx_RenderDrawPolygon(SDL_Renderer * renderer, const int * vx, const int *
 */
 int SDLEx_RenderDrawAAPolygon(SDL_Renderer * renderer, const int * vx, const int * vy, int n)
 {
-	int result;
+	SDL2_gfxPolygonShape polygon;
+	int key_len;
 	int i;
-	const int *x1, *y1, *x2, *y2;
 
 	/*
 	* Vertex array NULL check 
@@ -1980,90 +2167,70 @@ int SDLEx_RenderDrawAAPolygon(SDL_Renderer * renderer, const int * vx, const int
 	}
 
 	/*
-	* Pointer setup 
+	* Key is the shape and vertices relative to the first one 
 	*/
-	x1 = x2 = vx;
-	y1 = y2 = vy;
-	x2++;
-	y2++;
-
-	/*
-	* Draw 
-	*/
-	result = 0;
+	key_len = 2 * n;
+	std::vector<int> key(key_len);
+	key[0] = SDL2_gfxCoveragePolygon;
+	key[1] = n;
 	for (i = 1; i < n; i++) {
-    result |= RenderDrawLine(renderer, *x1, *y1, *x2, *y2, SDL_FALSE);
-		x1 = x2;
-		y1 = y2;
-		x2++;
-		y2++;
+		key[2 * i] = vx[i] - vx[0];
+		key[2 * i + 1] = vy[i] - vy[0];
 	}
 
-	result |= RenderDrawLine(renderer, *x1, *y1, *vx, *vy, SDL_FALSE);
-
-	return (result);
+	polygon.vx = vx;
+	polygon.vy = vy;
+	polygon.n = n;
+	return SDLEx_RenderCoverage(renderer, &key[0], key_len,
+		vx[0], vy[0], RasterizePolygonShape, &polygon);
 }
 
 /* ---- Filled Polygon */
 
 /*!
-\brief Internal helper qsort callback functions used in filled polygon drawing.
-
-\param a The surface to draw on.
-\param b Vertex array containing X coordinates of the points of the polygon.
-
-\returns Returns 0 if a==b, a negative number if a<b or a positive number if a>b.
-*/
-int _gfxPrimitivesCompareInt(const void *a, const void *b)
-{
-	return (*(const int *) a) - (*(const int *) b);
-}
-
-/*!
-\brief Global vertex array to use if optional parameters are not given in filledPolygonMT calls.
-
-Note: Used for non-multithreaded (default) operation of filledPolygonMT.
+\brief Edge of a filled polygon in the edge table, y1 < y2.
 */
-static int *gfxPrimitivesPolyIntsGlobal = NULL;
+typedef struct {
+	int x1, y1;
+	int x2, y2;
+} SDL2_gfxPolyEdge;
 
 /*!
-\brief Flag indicating if global vertex array was already allocated.
-
-Note: Used for non-multithreaded (default) operation of filledPolygonMT.
+\brief Internal helper qsort callback to order edges by their top scanline.
 */
-static int gfxPrimitivesPolyAllocatedGlobal = 0;
+int _gfxPrimitivesCompareEdge(const void *a, const void *b)
+{
+	return ((const SDL2_gfxPolyEdge *) a)->y1 - ((const SDL2_gfxPolyEdge *) b)->y1;
+}
 
 /*!
-\brief Draw filled polygon with alpha blending (multi-threaded capable).
+\brief Scan convert a polygon into spans using an active edge table.
 
-Note: The last two parameters are optional; but are required for multithreaded operation.  
+Edges are sorted once by their top scanline. Each scanline only visits edges
+crossing it, keeps their intersections in order with an insertion sort (the order
+rarely changes between scanlines). Scratch memory is allocated per call so the
+function is reentrant and can be used from several threads.
 
-\param renderer The renderer to draw on.
-\param vx Vertex array containing X coordinates of the points of the filled polygon.
-\param vy Vertex array containing Y coordinates of the points of the filled polygon.
+\param vx Vertex array containing X coordinates of the points of the polygon.
+\param vy Vertex array containing Y coordinates of the points of the polygon.
 \param n Number of points in the vertex array. Minimum number is 3.
-\param r The red value of the filled polygon to draw. 
-\param g The green value of the filled polygon to draw. 
-\param b The blue value of the filled polygon to draw. 
-\param a The alpha value of the filled polygon to draw.
-\param polyInts Preallocated, temporary vertex array used for sorting vertices. Required for multithreaded operation; set to NULL otherwise.
-\param polyAllocated Flag indicating if temporary vertex array was allocated. Required for multithreaded operation; set to NULL otherwise.
+\param spansOut Receives the spans allocated with malloc, the caller frees them.
 
-\returns Returns 0 on success, -1 on failure.
+\returns Returns the number of spans, -1 on failure.
 */
-int RenderFillPolygon_MT(SDL_Renderer * renderer, const int * vx, const int * vy, int n, int **polyInts, int *polyAllocated)
+int SDLEx_PolygonSpans(const int * vx, const int * vy, int n, SDL_Rect ** spansOut)
 {
-	int result;
-	int i;
-	int y, xa, xb;
+	int i, j;
+	int y, xa, xb, xt;
 	int miny, maxy;
-	int x1, y1;
-	int x2, y2;
-	int ind1, ind2;
-	int ints;
-	int *gfxPrimitivesPolyInts = NULL;
-	int *gfxPrimitivesPolyIntsNew = NULL;
-	int gfxPrimitivesPolyAllocated = 0;
+	int edges, next, active, ints;
+	SDL2_gfxPolyEdge *edgeTable;
+	SDL2_gfxPolyEdge *e;
+	int *activeEdges;
+	int *polyInts;
+	SDL_Rect *spans;
+	SDL_Rect *spansNew;
+	int spansCount, spansAllocated;
 
 	/*
 	* Vertex array NULL check 
@@ -2083,121 +2250,145 @@ int RenderFillPolygon_MT(SDL_Renderer * renderer, const int * vx, const int * vy
 	}
 
 	/*
-	* Map polygon cache  
-	*/
-	if ((polyInts==NULL) || (polyAllocated==NULL)) {
-		/* Use global cache */
-		gfxPrimitivesPolyInts = gfxPrimitivesPolyIntsGlobal;
-		gfxPrimitivesPolyAllocated = gfxPrimitivesPolyAllocatedGlobal;
-	} else {
-		/* Use local cache */
-		gfxPrimitivesPolyInts = *polyInts;
-		gfxPrimitivesPolyAllocated = *polyAllocated;
-	}
-
-	/*
-	* Allocate temp array, only grow array 
-	*/
-	if (!gfxPrimitivesPolyAllocated) {
-		gfxPrimitivesPolyInts = (int *) malloc(sizeof(int) * n);
-		gfxPrimitivesPolyAllocated = n;
-	} else {
-		if (gfxPrimitivesPolyAllocated < n) {
-			gfxPrimitivesPolyIntsNew = (int *) realloc(gfxPrimitivesPolyInts, sizeof(int) * n);
-			if (!gfxPrimitivesPolyIntsNew) {
-				if (!gfxPrimitivesPolyInts) {
-					free(gfxPrimitivesPolyInts);
-					gfxPrimitivesPolyInts = NULL;
-				}
-				gfxPrimitivesPolyAllocated = 0;
-			} else {
-				gfxPrimitivesPolyInts = gfxPrimitivesPolyIntsNew;
-				gfxPrimitivesPolyAllocated = n;
-			}
-		}
-	}
-
-	/*
-	* Check temp array
-	*/
-	if (gfxPrimitivesPolyInts==NULL) {        
-		gfxPrimitivesPolyAllocated = 0;
-	}
-
-	/*
-	* Update cache variables
-	*/
-	if ((polyInts==NULL) || (polyAllocated==NULL)) { 
-		gfxPrimitivesPolyIntsGlobal =  gfxPrimitivesPolyInts;
-		gfxPrimitivesPolyAllocatedGlobal = gfxPrimitivesPolyAllocated;
-	} else {
-		*polyInts = gfxPrimitivesPolyInts;
-		*polyAllocated = gfxPrimitivesPolyAllocated;
-	}
-
-	/*
-	* Check temp array again
+	* Per call scratch: edge table, active edge indices and intersections
 	*/
-	if (gfxPrimitivesPolyInts==NULL) {        
-		return(-1);
+	edgeTable = (SDL2_gfxPolyEdge *) malloc(sizeof(SDL2_gfxPolyEdge) * n + sizeof(int) * n * 2);
+	if (edgeTable == NULL) {
+		return (-1);
 	}
+	activeEdges = (int *) (edgeTable + n);
+	polyInts = activeEdges + n;
 
 	/*
-	* Determine Y maxima 
+	* Build edge table of non-horizontal edges, determine Y maxima
 	*/
 	miny = vy[0];
 	maxy = vy[0];
-	for (i = 1; (i < n); i++) {
+	edges = 0;
+	for (i = 0; (i < n); i++) {
+		int ind1 = (i == 0) ? n - 1 : i - 1;
 		if (vy[i] < miny) {
 			miny = vy[i];
 		} else if (vy[i] > maxy) {
 			maxy = vy[i];
 		}
+		if (vy[ind1] == vy[i]) {
+			continue;
+		}
+		e = &edgeTable[edges++];
+		if (vy[ind1] < vy[i]) {
+			e->x1 = vx[ind1]; e->y1 = vy[ind1];
+			e->x2 = vx[i];    e->y2 = vy[i];
+		} else {
+			e->x1 = vx[i];    e->y1 = vy[i];
+			e->x2 = vx[ind1]; e->y2 = vy[ind1];
+		}
 	}
+	qsort(edgeTable, edges, sizeof(SDL2_gfxPolyEdge), _gfxPrimitivesCompareEdge);
+
+	spansAllocated = (maxy - miny + 1) * 2;
+	spans = (SDL_Rect *) malloc(sizeof(SDL_Rect) * spansAllocated);
+	if (spans == NULL) {
+		free(edgeTable);
+		return (-1);
+	}
+	spansCount = 0;
 
 	/*
-	* Draw, scanning y 
+	* Scan y, edges become active at their top and retire at their bottom
+	* scanline, except the bottom one of the polygon which is included
 	*/
-	result = 0;
+	next = 0;
+	active = 0;
 	for (y = miny; (y <= maxy); y++) {
-		ints = 0;
-		for (i = 0; (i < n); i++) {
-			if (!i) {
-				ind1 = n - 1;
-				ind2 = 0;
-			} else {
-				ind1 = i - 1;
-				ind2 = i;
+		j = 0;
+		for (i = 0; (i < active); i++) {
+			e = &edgeTable[activeEdges[i]];
+			if ((y < e->y2) || (y == maxy && e->y2 == maxy)) {
+				activeEdges[j++] = activeEdges[i];
 			}
-			y1 = vy[ind1];
-			y2 = vy[ind2];
-			if (y1 < y2) {
-				x1 = vx[ind1];
-				x2 = vx[ind2];
-			} else if (y1 > y2) {
-				y2 = vy[ind1];
-				y1 = vy[ind2];
-				x2 = vx[ind1];
-				x1 = vx[ind2];
-			} else {
-				continue;
-			}
-			if ( ((y >= y1) && (y < y2)) || ((y == maxy) && (y > y1) && (y <= y2)) ) {
-				gfxPrimitivesPolyInts[ints++] = ((65536 * (y - y1)) / (y2 - y1)) * (x2 - x1) + (65536 * x1);
-			} 	    
+		}
+		active = j;
+		while ((next < edges) && (edgeTable[next].y1 <= y)) {
+			activeEdges[active++] = next++;
 		}
 
-		qsort(gfxPrimitivesPolyInts, ints, sizeof(int), _gfxPrimitivesCompareInt);
+		/*
+		* Intersections in 16.16 fixed point, kept sorted by insertion
+		*/
+		ints = 0;
+		for (i = 0; (i < active); i++) {
+			e = &edgeTable[activeEdges[i]];
+			xt = ((65536 * (y - e->y1)) / (e->y2 - e->y1)) * (e->x2 - e->x1) + (65536 * e->x1);
+			for (j = ints; (j > 0) && (polyInts[j - 1] > xt); j--) {
+				polyInts[j] = polyInts[j - 1];
+			}
+			polyInts[j] = xt;
+			ints++;
+		}
 
-		for (i = 0; (i < ints); i += 2) {
-			xa = gfxPrimitivesPolyInts[i] + 1;
+		for (i = 0; (i + 1 < ints); i += 2) {
+			xa = polyInts[i] + 1;
 			xa = (xa >> 16) + ((xa & 32768) >> 15);
-			xb = gfxPrimitivesPolyInts[i+1] - 1;
+			xb = polyInts[i+1] - 1;
 			xb = (xb >> 16) + ((xb & 32768) >> 15);
-			result |= SDL_RenderDrawLine(renderer, xa, y, xb, y);
+			if (xb < xa) {
+				xt = xa;
+				xa = xb;
+				xb = xt;
+			}
+			if (spansCount == spansAllocated) {
+				spansNew = (SDL_Rect *) realloc(spans, sizeof(SDL_Rect) * spansAllocated * 2);
+				if (spansNew == NULL) {
+					free(spans);
+					free(edgeTable);
+					return (-1);
+				}
+				spans = spansNew;
+				spansAllocated *= 2;
+			}
+			spans[spansCount].x = xa;
+			spans[spansCount].y = y;
+			spans[spansCount].w = xb - xa + 1;
+			spans[spansCount].h = 1;
+			spansCount++;
 		}
 	}
 
+	free(edgeTable);
+	*spansOut = spans;
+	return (spansCount);
+}
+
+/*!
+\brief Draw filled polygon with alpha blending using an active edge table.
+
+All spans of the polygon are submitted with a single SDL_RenderFillRects call.
+
+\param renderer The renderer to draw on.
+\param vx Vertex array containing X coordinates of the points of the filled polygon.
+\param vy Vertex array containing Y coordinates of the points of the filled polygon.
+\param n Number of points in the vertex array. Minimum number is 3.
+
+\returns Returns 0 on success, -1 on failure.
+*/
+int RenderFillPolygon_AET(SDL_Renderer * renderer, const int * vx, const int * vy, int n)
+{
+	int result;
+	int spansCount;
+	SDL_Rect *spans;
+
+	spansCount = SDLEx_PolygonSpans(vx, vy, n, &spans);
+	if (spansCount < 0) {
+		return (-1);
+	}
+
+	result = SDLEx_BatchSync(renderer);
+	if (spansCount > 0) {
+		result |= SDL_RenderFillRects(renderer, spans, spansCount);
+	}
+
+	free(spans);
 	return (result);
 }
 
@@ -2213,7 +2404,7 @@ int RenderFillPolygon_MT(SDL_Renderer * renderer, const int * vx, const int * vy
 */
 int SDLEx_RenderFillPolygon(SDL_Renderer * renderer, const int * vx, const int * vy, int n)
 {
-	return RenderFillPolygon_MT(renderer, vx, vy, n, NULL, NULL);
+	return RenderFillPolygon_AET(renderer, vx, vy, n);
 }
 
 /* ---- Textured Polygon */
@@ -2286,7 +2477,7 @@ int RenderDrawTexturedLine(SDL_Renderer *renderer, int x1, int x2, int y, SDL_Te
 		source_rect.x = texture_x_walker;
 		dst_rect.x= x1;
 		dst_rect.w = source_rect.w;
-		result = (SDL_RenderCopy(renderer, texture, &source_rect, &dst_rect) == 0);
+		result |= SDL_RenderCopy(renderer, texture, &source_rect, &dst_rect);
 	} else { 
 		// we need to draw multiple times
 		// draw the first segment
@@ -2295,7 +2486,7 @@ int RenderDrawTexturedLine(SDL_Renderer *renderer, int x1, int x2, int y, SDL_Te
 		source_rect.x = texture_x_walker;
 		dst_rect.x= x1;
 		dst_rect.w = source_rect.w;
-		result |= (SDL_RenderCopy(renderer, texture, &source_rect, &dst_rect) == 0);
+		result |= SDL_RenderCopy(renderer, texture, &source_rect, &dst_rect);
 		write_width = texture_w;
 
 		// now draw the rest
@@ -2308,7 +2499,7 @@ int RenderDrawTexturedLine(SDL_Renderer *renderer, int x1, int x2, int y, SDL_Te
 			source_rect.w = write_width;
 			dst_rect.x = x1 + pixels_written;
 			dst_rect.w = source_rect.w;
-			result |= (SDL_RenderCopy(renderer, texture, &source_rect, &dst_rect) == 0);
+			result |= SDL_RenderCopy(renderer, texture, &source_rect, &dst_rect);
 			pixels_written += write_width;
 		}
 	}
@@ -2317,179 +2508,68 @@ int RenderDrawTexturedLine(SDL_Renderer *renderer, int x1, int x2, int y, SDL_Te
 }
 
 /*!
-\brief Draws a polygon filled with the given texture (Multi-Threading Capable). 
+\brief Draws a polygon filled with the given texture.
+
+The texture is repeated over the polygon. With SDL 2.0.18 or later the spans
+of the polygon are cached by its shape and submitted as UV mapped quads with a
+single SDL_RenderGeometry call, otherwise each span is copied separately.
+The texture's own blend, color and alpha modes apply. The renderer is not presented.
 
 \param renderer The renderer to draw on.
 \param vx array of x vector components
-\param vy array of x vector components
+\param vy array of y vector components
 \param n the amount of vectors in the vx and vy array
-\param texture the sdl surface to use to fill the polygon
+\param texture the texture to fill the polygon with, it must belong to the renderer
 \param texture_dx the offset of the texture relative to the screeen. If you move the polygon 10 pixels 
 to the left and want the texture to apear the same you need to increase the texture_dx value
 \param texture_dy see texture_dx
-\param polyInts Preallocated temp array storage for vertex sorting (used for multi-threaded operation)
-\param polyAllocated Flag indicating oif the temp array was allocated (used for multi-threaded operation)
 
 \returns Returns 0 on success, -1 on failure.
 */
-int RenderDrawTexturedPolygon_MT(SDL_Renderer *renderer, const int * vx, const int * vy, int n, 
-	SDL_Surface * texture, int texture_dx, int texture_dy, int **polyInts, int *polyAllocated)
+int SDLEx_RenderFillTexturedPolygon(SDL_Renderer *renderer, const int * vx, const int * vy, int n, SDL_Texture *texture, int texture_dx, int texture_dy)
 {
+	SDLEx_BatchSync(renderer);
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	return SDLEx_RenderFillTexturedPolygonMesh(renderer, vx, vy, n, texture, texture_dx, texture_dy);
+#else
 	int result;
 	int i;
-	int y, xa, xb;
-	int minx,maxx,miny, maxy;
-	int x1, y1;
-	int x2, y2;
-	int ind1, ind2;
-	int ints;
-	int *gfxPrimitivesPolyInts = NULL;
-	int gfxPrimitivesPolyAllocated = 0;
-	SDL_Texture *textureAsTexture = NULL;
+	int tw, th;
+	int spansCount;
+	SDL_Rect *spans;
 
-	/*
-	* Sanity check number of edges
-	*/
-	if (n < 3) {
+	if (renderer == NULL || texture == NULL) {
 		return -1;
 	}
-
-	/*
-	* Map polygon cache  
-	*/
-	if ((polyInts==NULL) || (polyAllocated==NULL)) {
-		/* Use global cache */
-		gfxPrimitivesPolyInts = gfxPrimitivesPolyIntsGlobal;
-		gfxPrimitivesPolyAllocated = gfxPrimitivesPolyAllocatedGlobal;
-	} else {
-		/* Use local cache */
-		gfxPrimitivesPolyInts = *polyInts;
-		gfxPrimitivesPolyAllocated = *polyAllocated;
-	}
-
-	/*
-	* Allocate temp array, only grow array 
-	*/
-	if (!gfxPrimitivesPolyAllocated) {
-		gfxPrimitivesPolyInts = (int *) malloc(sizeof(int) * n);
-		gfxPrimitivesPolyAllocated = n;
-	} else {
-		if (gfxPrimitivesPolyAllocated < n) {
-			gfxPrimitivesPolyInts = (int *) realloc(gfxPrimitivesPolyInts, sizeof(int) * n);
-			gfxPrimitivesPolyAllocated = n;
-		}
-	}
-
-	/*
-	* Check temp array
-	*/
-	if (gfxPrimitivesPolyInts==NULL) {        
-		gfxPrimitivesPolyAllocated = 0;
-	}
-
-	/*
-	* Update cache variables
-	*/
-	if ((polyInts==NULL) || (polyAllocated==NULL)) { 
-		gfxPrimitivesPolyIntsGlobal =  gfxPrimitivesPolyInts;
-		gfxPrimitivesPolyAllocatedGlobal = gfxPrimitivesPolyAllocated;
-	} else {
-		*polyInts = gfxPrimitivesPolyInts;
-		*polyAllocated = gfxPrimitivesPolyAllocated;
-	}
-
-	/*
-	* Check temp array again
-	*/
-	if (gfxPrimitivesPolyInts==NULL) {        
-		return(-1);
-	}
-
-	/*
-	* Determine X,Y minima,maxima 
-	*/
-	miny = vy[0];
-	maxy = vy[0];
-	minx = vx[0];
-	maxx = vx[0];
-	for (i = 1; (i < n); i++) {
-		if (vy[i] < miny) {
-			miny = vy[i];
-		} else if (vy[i] > maxy) {
-			maxy = vy[i];
-		}
-		if (vx[i] < minx) {
-			minx = vx[i];
-		} else if (vx[i] > maxx) {
-			maxx = vx[i];
-		}
+	if (SDL_QueryTexture(texture, NULL, NULL, &tw, &th) != 0 || tw <= 0 || th <= 0) {
+		return -1;
 	}
 
-    /* Create texture for drawing */
-	textureAsTexture = SDL_CreateTextureFromSurface(renderer, texture);
-	if (textureAsTexture == NULL)
-	{
+	spansCount = SDLEx_PolygonSpans(vx, vy, n, &spans);
+	if (spansCount < 0) {
 		return -1;
 	}
-	SDL_SetTextureBlendMode(textureAsTexture, SDL_BLENDMODE_BLEND);
-	
-	/*
-	* Draw, scanning y 
-	*/
-	result = 0;
-	for (y = miny; (y <= maxy); y++) {
-		ints = 0;
-		for (i = 0; (i < n); i++) {
-			if (!i) {
-				ind1 = n - 1;
-				ind2 = 0;
-			} else {
-				ind1 = i - 1;
-				ind2 = i;
-			}
-			y1 = vy[ind1];
-			y2 = vy[ind2];
-			if (y1 < y2) {
-				x1 = vx[ind1];
-				x2 = vx[ind2];
-			} else if (y1 > y2) {
-				y2 = vy[ind1];
-				y1 = vy[ind2];
-				x2 = vx[ind1];
-				x1 = vx[ind2];
-			} else {
-				continue;
-			}
-			if ( ((y >= y1) && (y < y2)) || ((y == maxy) && (y > y1) && (y <= y2)) ) {
-				gfxPrimitivesPolyInts[ints++] = ((65536 * (y - y1)) / (y2 - y1)) * (x2 - x1) + (65536 * x1);
-			} 
-		}
-
-		qsort(gfxPrimitivesPolyInts, ints, sizeof(int), _gfxPrimitivesCompareInt);
 
-		for (i = 0; (i < ints); i += 2) {
-			xa = gfxPrimitivesPolyInts[i] + 1;
-			xa = (xa >> 16) + ((xa & 32768) >> 15);
-			xb = gfxPrimitivesPolyInts[i+1] - 1;
-			xb = (xb >> 16) + ((xb & 32768) >> 15);
-			result |= RenderDrawTexturedLine(renderer, xa, xb, y, textureAsTexture, texture->w, texture->h, texture_dx, texture_dy);
-		}
+	result = 0;
+	for (i = 0; i < spansCount; i++) {
+		result |= RenderDrawTexturedLine(renderer, spans[i].x, spans[i].x + spans[i].w - 1, spans[i].y, 
+			texture, tw, th, texture_dx, texture_dy);
 	}
 
-	SDL_RenderPresent(renderer);
-	SDL_DestroyTexture(textureAsTexture);
-
+	free(spans);
 	return (result);
+#endif
 }
 
 /*!
-\brief Draws a polygon filled with the given texture. 
+\brief Draws a polygon filled with the given surface. 
 
-This standard version is calling multithreaded versions with NULL cache parameters.
+A texture is created from the surface on each call, keep a texture and use
+SDLEx_RenderFillTexturedPolygon to draw the same fill repeatedly.
 
 \param renderer The renderer to draw on.
 \param vx array of x vector components
-\param vy array of x vector components
+\param vy array of y vector components
 \param n the amount of vectors in the vx and vy array
 \param texture the sdl surface to use to fill the polygon
 \param texture_dx the offset of the texture relative to the screeen. if you move the polygon 10 pixels 
@@ -2500,10 +2580,23 @@ to the left and want the texture to apear the same you need to increase the text
 */
 int SDLEx_RenderDrawTexturedPolygon(SDL_Renderer *renderer, const int * vx, const int * vy, int n, SDL_Surface *texture, int texture_dx, int texture_dy)
 {
-	/*
-	* Draw
-	*/
-	return (RenderDrawTexturedPolygon_MT(renderer, vx, vy, n, texture, texture_dx, texture_dy, NULL, NULL));
+	int result;
+	SDL_Texture *textureAsTexture;
+
+	if (n < 3) {
+		return -1;
+	}
+
+	textureAsTexture = SDL_CreateTextureFromSurface(renderer, texture);
+	if (textureAsTexture == NULL) {
+		return -1;
+	}
+	SDL_SetTextureBlendMode(textureAsTexture, SDL_BLENDMODE_BLEND);
+
+	result = SDLEx_RenderFillTexturedPolygon(renderer, vx, vy, n, textureAsTexture, texture_dx, texture_dy);
+
+	SDL_DestroyTexture(textureAsTexture);
+	return (result);
 }
 
 /* ---- Bezier curve */
@@ -2584,7 +2677,7 @@ int SDLEx_RenderDrawBezierCurve(SDL_Renderer * renderer, const int * vx, const i
 	int result = 0;
 	int i;
 	double *x, *y, t, stepsize;
-	int x1, y1, x2, y2;
+	SDL_Point *points;
 
 	/*
 	* Sanity check 
@@ -2616,24 +2709,32 @@ int SDLEx_RenderDrawBezierCurve(SDL_Renderer * renderer, const int * vx, const i
 	x[n]=(double)vx[0];
 	y[n]=(double)vy[0];
 
+	/* Curve points, drawn as one polyline */
+	if ((points=(SDL_Point *)malloc(sizeof(SDL_Point)*(n*s+2)))==NULL) {
+		free(x);
+		free(y);
+		return(-1);
+	}
+
 	/*
 	* Draw 
 	*/
 	t=0.0;
-	x1=(int)lrint(EvaluateBezier(x,n+1,t));
-	y1=(int)lrint(EvaluateBezier(y,n+1,t));
+	points[0].x=(int)lrint(EvaluateBezier(x,n+1,t));
+	points[0].y=(int)lrint(EvaluateBezier(y,n+1,t));
 	for (i = 0; i <= (n*s); i++) {
 		t += stepsize;
-		x2=(int)EvaluateBezier(x,n,t);
-		y2=(int)EvaluateBezier(y,n,t);
-		result |= SDL_RenderDrawLine(renderer, x1, y1, x2, y2);
-		x1 = x2;
-		y1 = y2;
+		points[i+1].x=(int)EvaluateBezier(x,n,t);
+		points[i+1].y=(int)EvaluateBezier(y,n,t);
 	}
+	SDLEx_BatchBegin(renderer);
+	result |= SDLEx_BatchLines(renderer, points, n*s+2);
+	result |= SDLEx_BatchEnd(renderer);
 
 	/* Clean up temporary array */
 	free(x);
 	free(y);
+	free(points);
 
 	return (result);
 }
@@ -2771,7 +2872,7 @@ void MurphyParaline(SDL2_gfxMurphyIterator *m, int x, int y, int d1)
 
 	for (p = 0; p <= m->u; p++) {
 
-		SDL_RenderDrawPoint(m->renderer, x, y);
+		SDLEx_BatchPoint(m->renderer, x, y);
 
 		if (d1 <= m->kt) {
 			if (m->oct2 == 0) {
@@ -2880,22 +2981,22 @@ void MurphyIteration(SDL2_gfxMurphyIterator *m, uint8_t miter,
 			*/
 			InitializeBresen(&b, m2x, m2y, m1x, m1y);
 			do {
-				SDL_RenderDrawPoint(m->renderer, b.x, b.y);
+				SDLEx_BatchPoint(m->renderer, b.x, b.y);
 			} while (NextBresen(&b)==0);
 
 			InitializeBresen(&b, m1x, m1y, ml1bx, ml1by);
 			do {
-				SDL_RenderDrawPoint(m->renderer, b.x, b.y);
+				SDLEx_BatchPoint(m->renderer, b.x, b.y);
 			} while (NextBresen(&b)==0);
 
 			InitializeBresen(&b, ml1bx, ml1by, ml2bx, ml2by);
 			do {
-				SDL_RenderDrawPoint(m->renderer, b.x, b.y);
+				SDLEx_BatchPoint(m->renderer, b.x, b.y);
 			} while (NextBresen(&b)==0);
 
 			InitializeBresen(&b, ml2bx, ml2by, m2x, m2y);
 			do {
-				SDL_RenderDrawPoint(m->renderer, b.x, b.y);
+				SDLEx_BatchPoint(m->renderer, b.x, b.y);
 			} while (NextBresen(&b)==0);
 
 			px[0] = m1x;
@@ -3147,8 +3248,9 @@ int SDLEx_RenderDrawThickLine(SDL_Renderer *renderer, int x1, int y1, int x2, in
 	* Draw
 	*/
 	m.renderer = renderer;
+	SDLEx_BatchBegin(renderer);
 	MurphyWideline(&m, x1, y1, x2, y2, width, 0);
 	MurphyWideline(&m, x1, y1, x2, y2, width, 1);
 
-	return(0);
+	return(SDLEx_BatchEnd(renderer));
 }
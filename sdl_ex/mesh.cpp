@@ -0,0 +1,408 @@
+#include "sdl_ex.h"
+#include "polygon.h"
+#include "batch.h"
+#include <stdlib.h>
+#include <map>
+#include <vector>
+
+/*
+ * Tessellated filled shapes.
+ * Each shape is turned into a fan of triangles around its center once
+ * per set of parameters, cached meshes are only translated and colored
+ * on draw and submitted with a single SDL_RenderGeometry call.
+ */
+
+static SDLEx_FillBackend g_fill_backend = SDLEX_FILL_SPANS;
+
+void SDLEx_SetFillBackend(SDLEx_FillBackend backend)
+{
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+  g_fill_backend = backend;
+#else
+  // no geometry rendering in this SDL
+  g_fill_backend = SDLEX_FILL_SPANS;
+#endif
+}
+
+SDLEx_FillBackend SDLEx_GetFillBackend(void)
+{
+  return g_fill_backend;
+}
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+
+typedef enum {
+  mesh_ellipse = 0,
+  mesh_pie = 1,
+  mesh_rounded_rect = 2
+} mesh_shape;
+
+struct mesh_key {
+  int shape;
+  int a, b, c, d;
+  int segments;
+
+  bool operator<(const mesh_key & o) const
+  {
+    if (shape != o.shape) return shape < o.shape;
+    if (a != o.a) return a < o.a;
+    if (b != o.b) return b < o.b;
+    if (c != o.c) return c < o.c;
+    if (d != o.d) return d < o.d;
+    return segments < o.segments;
+  }
+};
+
+/* positions relative to the shape anchor, first one is the fan center */
+struct mesh {
+  std::vector<SDL_FPoint> points;
+  std::vector<int> indices;
+};
+
+typedef std::map<mesh_key, mesh> mesh_cache;
+
+/* spans of polygons keyed by their vertices relative to the first one */
+typedef std::map<std::vector<int>, std::vector<SDL_Rect> > spans_cache;
+
+// renderers are used from the main thread only, as SDL requires
+static mesh_cache g_meshes;
+static spans_cache g_polygons;
+static std::vector<int> g_polygon_key;
+static std::vector<SDL_Vertex> g_vertices;
+static std::vector<int> g_indices;
+
+// forget all meshes when this many are cached
+static const size_t max_cached_meshes = 1024;
+static const size_t max_cached_polygons = 256;
+
+void SDLEx_ClearMeshCache(void)
+{
+  g_meshes.clear();
+  g_polygons.clear();
+}
+
+/* segments for an arc so that chords stay within a quarter pixel of it */
+static int mesh_segments(SDL_Renderer * renderer, float radius, float arc)
+{
+  float sx = 1.0f, sy = 1.0f;
+  SDL_RenderGetScale(renderer, &sx, &sy);
+  float r = radius * (sx > sy ? sx : sy);
+  int n = 3;
+  if (r > 0.25f) {
+    float step = 2.0f * acosf(1.0f - 0.25f / r);
+    n = (int)ceilf(arc / step);
+  }
+  if (n < 3) n = 3;
+  if (n > 1024) n = 1024;
+  return n;
+}
+
+static void mesh_fan(mesh & m, SDL_bool closed)
+{
+  int n = (int)m.points.size() - 1;
+  int last = closed ? n : n - 1;
+  m.indices.reserve(last * 3);
+  for (int i = 1; i <= last; ++i) {
+    m.indices.push_back(0);
+    m.indices.push_back(i);
+    m.indices.push_back(i < n ? i + 1 : 1);
+  }
+}
+
+static const mesh & mesh_get(const mesh_key & key)
+{
+  mesh_cache::iterator it = g_meshes.find(key);
+  if (it != g_meshes.end())
+    return it->second;
+  if (g_meshes.size() >= max_cached_meshes)
+    g_meshes.clear();
+
+  mesh & m = g_meshes[key];
+  SDL_FPoint p;
+  int n = key.segments;
+  switch (key.shape) {
+  case mesh_ellipse: {
+    // pixel centers are covered by the span rasterizer, so grow by half a pixel
+    float rx = key.a + 0.5f, ry = key.b + 0.5f;
+    p.x = 0.5f; p.y = 0.5f;
+    m.points.push_back(p);
+    for (int i = 0; i < n; ++i) {
+      float angle = (float)(2.0 * M_PI * i / n);
+      p.x = 0.5f + rx * cosf(angle);
+      p.y = 0.5f + ry * sinf(angle);
+      m.points.push_back(p);
+    }
+    mesh_fan(m, SDL_TRUE);
+    break;
+  }
+  case mesh_pie: {
+    float r = key.a + 0.5f;
+    float start = (float)(key.b * M_PI / 180.0);
+    float end = (float)(key.c * M_PI / 180.0);
+    p.x = 0.5f; p.y = 0.5f;
+    m.points.push_back(p);
+    for (int i = 0; i <= n; ++i) {
+      float angle = start + (end - start) * i / n;
+      p.x = 0.5f + r * cosf(angle);
+      p.y = 0.5f + r * sinf(angle);
+      m.points.push_back(p);
+    }
+    mesh_fan(m, SDL_FALSE);
+    break;
+  }
+  case mesh_rounded_rect: {
+    // a = width, b = height in pixels, c = corner radius
+    float w = (float)key.a, h = (float)key.b, r = (float)key.c;
+    float cx[4] = { w - r, r, r, w - r };
+    float cy[4] = { h - r, h - r, r, r };
+    int quarter = n / 4 > 0 ? n / 4 : 1;
+    p.x = w / 2; p.y = h / 2;
+    m.points.push_back(p);
+    for (int corner = 0; corner < 4; ++corner) {
+      for (int i = 0; i <= quarter; ++i) {
+        float angle = (float)(M_PI / 2 * (corner + (float)i / quarter));
+        p.x = cx[corner] + r * cosf(angle);
+        p.y = cy[corner] + r * sinf(angle);
+        m.points.push_back(p);
+      }
+    }
+    mesh_fan(m, SDL_TRUE);
+    break;
+  }
+  }
+  return m;
+}
+
+static int mesh_render(SDL_Renderer * renderer, const mesh & m, float x, float y)
+{
+  SDL_Color c;
+  if (SDL_GetRenderDrawColor(renderer, &c.r, &c.g, &c.b, &c.a) != 0)
+    return -1;
+
+  size_t n = m.points.size();
+  if (g_vertices.size() < n)
+    g_vertices.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    SDL_Vertex & v = g_vertices[i];
+    v.position.x = x + m.points[i].x;
+    v.position.y = y + m.points[i].y;
+    v.color = c;
+    v.tex_coord.x = 0.0f;
+    v.tex_coord.y = 0.0f;
+  }
+  SDLEx_BatchSync(renderer);
+  return SDL_RenderGeometry(renderer, NULL, &g_vertices[0], (int)n,
+                            &m.indices[0], (int)m.indices.size());
+}
+
+int SDLEx_RenderFillEllipseMesh(SDL_Renderer * renderer, int x, int y, int rx, int ry)
+{
+  if (renderer == NULL || rx < 0 || ry < 0)
+    return -1;
+  if (rx == 0 || ry == 0) {
+    SDLEx_BatchSync(renderer);
+    return SDL_RenderDrawLine(renderer, x - rx, y - ry, x + rx, y + ry);
+  }
+
+  mesh_key key;
+  key.shape = mesh_ellipse;
+  key.a = rx;
+  key.b = ry;
+  key.c = key.d = 0;
+  key.segments = mesh_segments(renderer, (float)(rx > ry ? rx : ry), (float)(2.0 * M_PI));
+  return mesh_render(renderer, mesh_get(key), (float)x, (float)y);
+}
+
+int SDLEx_RenderFillCircleMesh(SDL_Renderer * renderer, int x, int y, int rad)
+{
+  return SDLEx_RenderFillEllipseMesh(renderer, x, y, rad, rad);
+}
+
+int SDLEx_RenderFillPieMesh(SDL_Renderer * renderer, int x, int y, int rad, int start, int end)
+{
+  if (renderer == NULL || rad < 0)
+    return -1;
+  if (rad == 0) {
+    SDLEx_BatchSync(renderer);
+    return SDL_RenderDrawPoint(renderer, x, y);
+  }
+
+  // same angles fixup as the span pie
+  start = start % 360;
+  end = end % 360;
+  if (start > end)
+    end += 360;
+  if (start == end) {
+    double angle = start * M_PI / 180.0;
+    SDLEx_BatchSync(renderer);
+    return SDL_RenderDrawLine(renderer, x, y,
+      x + (int)(rad * cos(angle)), y + (int)(rad * sin(angle)));
+  }
+
+  mesh_key key;
+  key.shape = mesh_pie;
+  key.a = rad;
+  key.b = start;
+  key.c = end;
+  key.d = 0;
+  key.segments = mesh_segments(renderer, (float)rad, (float)((end - start) * M_PI / 180.0));
+  return mesh_render(renderer, mesh_get(key), (float)x, (float)y);
+}
+
+int SDLEx_RenderFillRoundedRectMesh(SDL_Renderer * renderer, int x1, int y1, int x2, int y2, int rad)
+{
+  int tmp;
+  if (renderer == NULL || rad < 0)
+    return -1;
+  if (x1 > x2) { tmp = x1; x1 = x2; x2 = tmp; }
+  if (y1 > y2) { tmp = y1; y1 = y2; y2 = tmp; }
+
+  // corners of the last pixels are included as by the span version
+  int w = x2 - x1 + 1;
+  int h = y2 - y1 + 1;
+  if (rad > w / 2) rad = w / 2;
+  if (rad > h / 2) rad = h / 2;
+  if (rad <= 1) {
+    SDL_Rect r = { x1, y1, w, h };
+    SDLEx_BatchSync(renderer);
+    return SDL_RenderFillRect(renderer, &r);
+  }
+
+  mesh_key key;
+  key.shape = mesh_rounded_rect;
+  key.a = w;
+  key.b = h;
+  key.c = rad;
+  key.d = 0;
+  key.segments = mesh_segments(renderer, (float)rad, (float)(2.0 * M_PI));
+  return mesh_render(renderer, mesh_get(key), (float)x1, (float)y1);
+}
+
+/* integer translation keeps the spans, so they are stored relative to the first vertex */
+static const std::vector<SDL_Rect> * polygon_spans(const int * vx, const int * vy, int n)
+{
+  g_polygon_key.resize(n * 2);
+  for (int i = 0; i < n; ++i) {
+    g_polygon_key[i * 2] = vx[i] - vx[0];
+    g_polygon_key[i * 2 + 1] = vy[i] - vy[0];
+  }
+  spans_cache::iterator it = g_polygons.find(g_polygon_key);
+  if (it != g_polygons.end())
+    return &it->second;
+
+  SDL_Rect * spans = NULL;
+  int count = SDLEx_PolygonSpans(vx, vy, n, &spans);
+  if (count < 0)
+    return NULL;
+  if (g_polygons.size() >= max_cached_polygons)
+    g_polygons.clear();
+
+  std::vector<SDL_Rect> & cached = g_polygons[g_polygon_key];
+  cached.assign(spans, spans + count);
+  free(spans);
+  for (size_t i = 0; i < cached.size(); ++i) {
+    cached[i].x -= vx[0];
+    cached[i].y -= vy[0];
+  }
+  return &cached;
+}
+
+static void textured_quad(const SDL_Color & c, float x, float y, float w,
+  float u, float v, float du, float dv)
+{
+  int base = (int)g_vertices.size();
+  SDL_Vertex q;
+  q.color = c;
+  q.position.x = x;     q.position.y = y;     q.tex_coord.x = u;      q.tex_coord.y = v;
+  g_vertices.push_back(q);
+  q.position.x = x + w; q.position.y = y;     q.tex_coord.x = u + du; q.tex_coord.y = v;
+  g_vertices.push_back(q);
+  q.position.x = x;     q.position.y = y + 1; q.tex_coord.x = u;      q.tex_coord.y = v + dv;
+  g_vertices.push_back(q);
+  q.position.x = x + w; q.position.y = y + 1; q.tex_coord.x = u + du; q.tex_coord.y = v + dv;
+  g_vertices.push_back(q);
+
+  g_indices.push_back(base);
+  g_indices.push_back(base + 1);
+  g_indices.push_back(base + 2);
+  g_indices.push_back(base + 2);
+  g_indices.push_back(base + 1);
+  g_indices.push_back(base + 3);
+}
+
+int SDLEx_RenderFillTexturedPolygonMesh(SDL_Renderer * renderer, const int * vx, const int * vy, int n,
+  SDL_Texture * texture, int texture_dx, int texture_dy)
+{
+  if (renderer == NULL || texture == NULL || vx == NULL || vy == NULL || n < 3)
+    return -1;
+
+  int tw, th;
+  if (SDL_QueryTexture(texture, NULL, NULL, &tw, &th) != 0 || tw <= 0 || th <= 0)
+    return -1;
+
+  // vertex colors stand in for the texture modulation of SDL_RenderCopy
+  SDL_Color c;
+  if (SDL_GetTextureColorMod(texture, &c.r, &c.g, &c.b) != 0 ||
+      SDL_GetTextureAlphaMod(texture, &c.a) != 0)
+    return -1;
+
+  const std::vector<SDL_Rect> * spans = polygon_spans(vx, vy, n);
+  if (spans == NULL)
+    return -1;
+  if (spans->empty())
+    return 0;
+
+  // texture coordinates are clamped, spans are split where the texture repeats
+  g_vertices.clear();
+  g_indices.clear();
+  float du = 1.0f / tw, dv = 1.0f / th;
+  for (size_t i = 0; i < spans->size(); ++i) {
+    const SDL_Rect & s = (*spans)[i];
+    int x = vx[0] + s.x;
+    int y = vy[0] + s.y;
+    int w = s.w;
+    // same texture offsets as the span by span version
+    int u = (x - texture_dx) % tw;
+    if (u < 0) u += tw;
+    int v = (y + texture_dy) % th;
+    if (v < 0) v += th;
+    while (w > 0) {
+      int len = w < tw - u ? w : tw - u;
+      textured_quad(c, (float)x, (float)y, (float)len, u * du, v * dv, len * du, dv);
+      x += len;
+      w -= len;
+      u = 0;
+    }
+  }
+  SDLEx_BatchSync(renderer);
+  return SDL_RenderGeometry(renderer, texture, &g_vertices[0], (int)g_vertices.size(),
+                            &g_indices[0], (int)g_indices.size());
+}
+
+#else
+
+void SDLEx_ClearMeshCache(void)
+{
+}
+
+int SDLEx_RenderFillEllipseMesh(SDL_Renderer *, int, int, int, int)
+{
+  return SDL_SetError("Filled meshes require SDL 2.0.18");
+}
+
+int SDLEx_RenderFillCircleMesh(SDL_Renderer *, int, int, int)
+{
+  return SDL_SetError("Filled meshes require SDL 2.0.18");
+}
+
+int SDLEx_RenderFillPieMesh(SDL_Renderer *, int, int, int, int, int)
+{
+  return SDL_SetError("Filled meshes require SDL 2.0.18");
+}
+
+int SDLEx_RenderFillRoundedRectMesh(SDL_Renderer *, int, int, int, int, int)
+{
+  return SDL_SetError("Filled meshes require SDL 2.0.18");
+}
+
+#endif
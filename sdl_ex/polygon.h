@@ -0,0 +1,34 @@
+#ifndef _SDLEX_POLYGON_H_
+#define _SDLEX_POLYGON_H_
+
+#include "sdl_ex.h"
+
+/*!
+\brief Scan convert a polygon into one pixel high spans.
+
+The spans cover the same pixels as SDLEx_RenderFillPolygon draws.
+
+\param vx Vertex array containing X coordinates of the points of the polygon.
+\param vy Vertex array containing Y coordinates of the points of the polygon.
+\param n Number of points in the vertex array. Minimum number is 3.
+\param spans Receives the spans allocated with malloc, the caller frees them.
+
+\returns Returns the number of spans, -1 on failure.
+*/
+int SDLEx_PolygonSpans(const int * vx, const int * vy, int n, SDL_Rect ** spans);
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+
+/*!
+\brief Draw a textured polygon from its cached spans with SDL_RenderGeometry.
+
+Arguments are the ones of SDLEx_RenderFillTexturedPolygon.
+
+\returns Returns 0 on success, -1 on failure.
+*/
+int SDLEx_RenderFillTexturedPolygonMesh(SDL_Renderer * renderer, const int * vx, const int * vy, int n,
+	SDL_Texture * texture, int texture_dx, int texture_dy);
+
+#endif
+
+#endif //_SDLEX_POLYGON_H_
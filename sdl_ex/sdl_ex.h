@@ -42,6 +42,27 @@ extern "C" {
 
   SDLEX_API int SDLEx_RenderDrawPointWeight(SDL_Renderer* renderer, int x, int y, uint32_t weight);
 
+  /* Anti-aliased lines, circles, ellipses and polygons are rasterized into
+     coverage textures cached by shape parameters, repeated draws are blits.
+     Textures are kept until the cache is full or cleared, clear it before
+     destroying a renderer */
+
+  SDLEX_API void SDLEx_ClearCoverageCache(void);
+
+  /* Batched mode.
+     Outlines, circle and ellipse fills and bezier curves collect their points
+     and lines and draw them with a few calls at the end of each primitive.
+     Between SDLEx_BeginBatch and SDLEx_EndBatch they are kept until the end
+     instead, i.e. for a frame of debug overlays. Draw color and blend mode
+     changes are respected. SDLEx draws which do not batch, such as AA shapes,
+     polygon, mesh and textured fills, flush pending pixels first. Plain
+     SDL_Render* calls and texture copies are reordered against the batch,
+     flush before them and before changing target, viewport, clip or scale */
+
+  SDLEX_API void SDLEx_BeginBatch(void);
+  SDLEX_API int SDLEx_FlushBatch(void);
+  SDLEX_API int SDLEx_EndBatch(void);
+
   /* Rectangle */
 
   SDLEX_API int SDLEx_RenderDrawRect(SDL_Renderer * renderer, int x1, int y1, int x2, int y2);
@@ -93,6 +114,33 @@ extern "C" {
   SDLEX_API int SDLEx_RenderFillPolygon(SDL_Renderer * renderer, const int * vx, const int * vy, int n);
   SDLEX_API int SDLEx_RenderDrawTexturedPolygon(SDL_Renderer * renderer, const int * vx, const int * vy, int n, SDL_Surface * texture,int texture_dx,int texture_dy);
 
+  /* Textured fill of a polygon with a texture of the renderer. Spans of the
+     polygon are cached by its shape and drawn with a single SDL_RenderGeometry
+     call with SDL 2.0.18 or later. The surface version above creates a
+     texture on every call */
+
+  SDLEX_API int SDLEx_RenderFillTexturedPolygon(SDL_Renderer * renderer, const int * vx, const int * vy, int n, SDL_Texture * texture, int texture_dx, int texture_dy);
+
+  /* Filled shapes backend.
+     SDLEX_FILL_SPANS rasterizes filled circles, ellipses, pies and rounded
+     rectangles into horizontal lines. SDLEX_FILL_MESH tessellates them into
+     triangle meshes cached by shape parameters and submitted with a single
+     SDL_RenderGeometry call each, it requires SDL 2.0.18 */
+
+  typedef enum {
+    SDLEX_FILL_SPANS = 0,
+    SDLEX_FILL_MESH  = 1
+  } SDLEx_FillBackend;
+
+  SDLEX_API void SDLEx_SetFillBackend(SDLEx_FillBackend backend);
+  SDLEX_API SDLEx_FillBackend SDLEx_GetFillBackend(void);
+  SDLEX_API void SDLEx_ClearMeshCache(void);
+
+  SDLEX_API int SDLEx_RenderFillCircleMesh(SDL_Renderer * renderer, int x, int y, int rad);
+  SDLEX_API int SDLEx_RenderFillEllipseMesh(SDL_Renderer * renderer, int x, int y, int rx, int ry);
+  SDLEX_API int SDLEx_RenderFillPieMesh(SDL_Renderer * renderer, int x, int y, int rad, int start, int end);
+  SDLEX_API int SDLEx_RenderFillRoundedRectMesh(SDL_Renderer * renderer, int x1, int y1, int x2, int y2, int rad);
+
   /* Bezier */
 
   SDLEX_API int SDLEx_RenderDrawBezierCurve(SDL_Renderer * renderer, const int * vx, const int * vy, int n, int s);
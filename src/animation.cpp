@@ -1,17 +1,64 @@
 #include "animation.h"
 
+static anim_scheduler * g_scheduler = NULL;
+
+// create empty animation
+anim::anim():
+  _slot(-1),
+  _mode(once),
+  _sheet(NULL),
+  _frame_duration(0),
+  _from(0),
+  _to(0),
+  _mod(1),
+  _current(0)
+{
+}
+
+anim::anim(const anim & other):
+  _slot(-1),
+  _mode(other._mode),
+  _sheet(other._sheet),
+  _frame_duration(other._frame_duration),
+  _from(other._from),
+  _to(other._to),
+  _mod(other._mod),
+  _current(other.current())
+{
+}
+
+anim & anim::operator=(const anim & other)
+{
+  if (this == &other)
+    return *this;
+  if (is_running())
+    anim_scheduler::instance()->remove(this);
+  _mode = other._mode;
+  _sheet = other._sheet;
+  _frame_duration = other._frame_duration;
+  _from = other._from;
+  _to = other._to;
+  _mod = other._mod;
+  _current = other.current();
+  return *this;
+}
+
+anim::~anim()
+{
+  anim_scheduler::instance()->remove(this);
+}
 
 // create new animation
 anim::anim(const sprites_sheet * sheet,
            const anim_mode mode,
            unsigned int frame_duration):
-  _timer(0),
+  _slot(-1),
   _mode(mode),
   _sheet(sheet),
   _frame_duration(frame_duration),
   _from(0),
   _to(_sheet->rows() * _sheet->cols() - 1),
-  _mod( _to > _from ? -1 : 1),
+  _mod( _to > _from ? 1 : -1),
   _current(_from)
 {
 }
@@ -22,13 +69,13 @@ anim::anim(const sprites_sheet * sheet,
            unsigned int frame_duration,
            int from,
            int to):
-  _timer(0),
+  _slot(-1),
   _mode(mode),
   _sheet(sheet),
   _frame_duration(frame_duration),
   _from(from),
   _to(to),
-  _mod( _to > _from ? -1 : 1),
+  _mod( _to > _from ? 1 : -1),
   _current(_from)
 {
 }
@@ -38,7 +85,7 @@ anim::anim(const sprites_sheet * sheet,
 //           int sprite_w, int sprite_h,
 //           const anim_mode mode,
 //           unsigned int frame_duration):
-//  _timer(0),
+//  _slot(-1),
 //  _mode(mode),
 //  _sheet(resources::get_sprites_sheet(sprites_sheet_resource, sprite_w, sprite_h)),
 //  _frame_duration(frame_duration),
@@ -65,53 +112,26 @@ anim::anim(const sprites_sheet * sheet,
 //{
 //}
 
-bool is_it_the_end(anim * a, int next)
+void anim::reset(int from, int to)
 {
-  return
-    (a->modifier() > 0 && (next < a->from() || next > a->to()))
-    ||
-    (a->modifier() < 0 && (next > a->from() || next < a->to()));
+  _from = from; _to = to;
+  _mod = (_to > _from ? 1 : -1);
+  if (is_running())
+    anim_scheduler::instance()->sync(this);
 }
 
-unsigned int schedule_callback(unsigned int interval, void *param)
+int anim::current() const
 {
-  anim * a = (anim*)param;
-  
-  // find out next animation frame index
-  int next = a->current() + a->modifier();
-  
-  if (is_it_the_end(a, next)) {
-
-    if (a->mode() == anim::once) {
-      // reached end of animation for "once"
-      a->stop(false);
-      return 0;
-    }
-
-    if (a->mode() == anim::repeat) {
-      // reach on the end borders for "repeat" mode
-      // restart from the begining in same direction
-      next = a->from();
-    }
-
-    if (a->mode() == anim::occilate) {
-      // reach on the end borders for "occilate" mode
-      // restart from current position backwards
-      a->reset(a->to(), a->from());
-      next = a->current();
-    }
-  }
-
-  // update frame 
-  a->set_current(next);
-  // return duration of the next frame
-  return a->frame_duration();
+  if (is_running())
+    return anim_scheduler::instance()->current(_slot);
+  return _current;
 }
 
-void anim::reset(int from, int to)
+void anim::set_current(int idx)
 {
-  _from = from; _to = to;
-  _mod = (_to > _from ? 1 : -1);
+  _current = idx;
+  if (is_running())
+    anim_scheduler::instance()->sync(this);
 }
 
 void anim::start()
@@ -124,10 +144,7 @@ void anim::start()
       _mod != 0 &&
       _to != _from)
   {
-    if (_timer) SDL_RemoveTimer(_timer);
-    _timer = SDL_AddTimer(_frame_duration, 
-                          schedule_callback,
-                          this);
+    anim_scheduler::instance()->add(this);
     // notify
     event start_ev(this);
     started(start_ev);
@@ -141,8 +158,8 @@ void anim::stop(bool reset_current)
     if (!is_running())
       throw std::runtime_error("Animation is already stopped");
 
-    SDL_RemoveTimer(_timer);
-    _timer = 0;
+    _current = current();
+    anim_scheduler::instance()->remove(this);
     if (reset_current)
       _current = _from;
 
@@ -150,3 +167,145 @@ void anim::stop(bool reset_current)
     event stop_ev(this);
     stopped(stop_ev);
 }
+
+/* Class anim_scheduler implementation */
+
+anim_scheduler * anim_scheduler::instance()
+{
+  if (g_scheduler == NULL) {
+    g_scheduler = new anim_scheduler();
+  }
+  return g_scheduler;
+}
+
+anim_scheduler::anim_scheduler():
+  _last_ticks(0)
+{
+}
+
+int anim_scheduler::add(anim * a)
+{
+  int slot = (int)_owner.size();
+  _owner.push_back(a);
+  // account time passed since last update so the first
+  // frame is displayed for its whole duration
+  _elapsed.push_back(_last_ticks != 0 ? (int32_t)(_last_ticks - SDL_GetTicks()) : 0);
+  _duration.push_back(0);
+  _phase.push_back(0);
+  _span.push_back(0);
+  _period.push_back(1);
+  _from.push_back(0);
+  _mod.push_back(1);
+  _mode.push_back(a->_mode);
+  _current.push_back(a->_current);
+  _finished.push_back(0);
+  a->_slot = slot;
+  sync(a);
+  return slot;
+}
+
+void anim_scheduler::sync(anim * a)
+{
+  int i = a->_slot;
+  int32_t span = a->_to > a->_from ? a->_to - a->_from : a->_from - a->_to;
+  int32_t phase = (_current[i] - a->_from) * a->_mod;
+  if (phase < 0) phase = 0;
+  if (phase > span) phase = span;
+
+  _duration[i] = max((int32_t)a->_frame_duration, 1);
+  _span[i] = span;
+  _period[i] = a->_mode == anim::occilate ? max(span * 2, 1) : span + 1;
+  _from[i] = a->_from;
+  _mod[i] = a->_mod;
+  _mode[i] = a->_mode;
+  _phase[i] = phase;
+  _current[i] = a->_from + a->_mod * phase;
+}
+
+void anim_scheduler::remove(anim * a)
+{
+  std::replace(_stopping.begin(), _stopping.end(), a, (anim*)NULL);
+
+  int i = a->_slot;
+  if (i < 0)
+    return;
+  a->_slot = -1;
+
+  // keep arrays dense, move the last animation into the free slot
+  int last = (int)_owner.size() - 1;
+  if (i != last) {
+    _owner[i] = _owner[last];
+    _elapsed[i] = _elapsed[last];
+    _duration[i] = _duration[last];
+    _phase[i] = _phase[last];
+    _span[i] = _span[last];
+    _period[i] = _period[last];
+    _from[i] = _from[last];
+    _mod[i] = _mod[last];
+    _mode[i] = _mode[last];
+    _current[i] = _current[last];
+    _finished[i] = _finished[last];
+    _owner[i]->_slot = i;
+  }
+  _owner.pop_back();
+  _elapsed.pop_back();
+  _duration.pop_back();
+  _phase.pop_back();
+  _span.pop_back();
+  _period.pop_back();
+  _from.pop_back();
+  _mod.pop_back();
+  _mode.pop_back();
+  _current.pop_back();
+  _finished.pop_back();
+}
+
+void anim_scheduler::update(uint32_t ticks)
+{
+  int32_t dt = _last_ticks != 0 ? (int32_t)(ticks - _last_ticks) : 0;
+  _last_ticks = ticks;
+  if (dt <= 0 || _owner.empty())
+    return;
+
+  size_t count = _owner.size();
+  int32_t * elapsed = &_elapsed[0];
+  const int32_t * duration = &_duration[0];
+  int32_t * phase = &_phase[0];
+  const int32_t * span = &_span[0];
+  const int32_t * period = &_period[0];
+  const int32_t * from = &_from[0];
+  const int32_t * mod = &_mod[0];
+  const int32_t * mode = &_mode[0];
+  int32_t * cur = &_current[0];
+  uint8_t * finished = &_finished[0];
+
+  // branch-free pass over all running animations,
+  // 'phase' is a frame offset from 'from' in [0, period)
+  for(size_t i = 0; i < count; ++i) {
+    int32_t e = elapsed[i] + dt;
+    int32_t steps = e > 0 ? e / duration[i] : 0;
+    elapsed[i] = e - steps * duration[i];
+
+    int32_t p = phase[i] + steps;
+    int32_t is_once = mode[i] == anim::once;
+    finished[i] = (uint8_t)(is_once & (p > span[i]));
+    p = is_once ? min(p, span[i]) : p % period[i];
+    phase[i] = p;
+
+    // occilate walks back after reaching the end
+    int32_t offset = p > span[i] ? period[i] - p : p;
+    cur[i] = from[i] + mod[i] * offset;
+  }
+
+  // stop finished animations after the pass, their handlers may
+  // start or stop other animations
+  for(size_t i = 0; i < count; ++i) {
+    if (finished[i]) _stopping.push_back(_owner[i]);
+  }
+  while (!_stopping.empty()) {
+    anim * a = _stopping.back();
+    _stopping.pop_back();
+    if (a != NULL && a->is_running())
+      a->stop(false);
+  }
+}
@@ -0,0 +1,272 @@
+#include "bitmap_font.h"
+#include <stdlib.h>
+
+typedef std::map<std::string, std::string> fnt_attrs;
+
+/* split "tag key=value key="quoted value" ..." line of a descriptor */
+static std::string parse_fnt_line(const std::string & line, fnt_attrs & attrs)
+{
+  attrs.clear();
+  size_t i = line.find_first_not_of(" \t");
+  if (i == std::string::npos)
+    return std::string();
+  size_t end = line.find_first_of(" \t", i);
+  std::string tag = line.substr(i, end == std::string::npos ? std::string::npos : end - i);
+
+  i = end;
+  while (i != std::string::npos && i < line.length()) {
+    i = line.find_first_not_of(" \t\r", i);
+    if (i == std::string::npos)
+      break;
+    size_t eq = line.find('=', i);
+    if (eq == std::string::npos)
+      break;
+    std::string key = line.substr(i, eq - i);
+    std::string value;
+    i = eq + 1;
+    if (i < line.length() && line[i] == '"') {
+      size_t close = line.find('"', i + 1);
+      value = line.substr(i + 1, close == std::string::npos ? std::string::npos : close - i - 1);
+      i = close == std::string::npos ? std::string::npos : close + 1;
+    }
+    else {
+      end = line.find_first_of(" \t\r", i);
+      value = line.substr(i, end == std::string::npos ? std::string::npos : end - i);
+      i = end;
+    }
+    attrs[key] = value;
+  }
+  return tag;
+}
+
+static int fnt_int(const fnt_attrs & attrs, const char * key)
+{
+  fnt_attrs::const_iterator it = attrs.find(key);
+  return it != attrs.end() ? atoi(it->second.c_str()) : 0;
+}
+
+bitmap_font::bitmap_font():
+  _base(0),
+  _page_w(0),
+  _page_h(0)
+{
+  clear();
+}
+
+bitmap_font::bitmap_font(const std::string & file_path):
+  _base(0),
+  _page_w(0),
+  _page_h(0)
+{
+  clear();
+  load(file_path);
+}
+
+bitmap_font::bitmap_font(const std::string & name, const char * data, size_t size):
+  _base(0),
+  _page_w(0),
+  _page_h(0)
+{
+  clear();
+  load(name, data, size);
+}
+
+bitmap_font::~bitmap_font()
+{
+  clear();
+}
+
+void bitmap_font::clear()
+{
+  std::vector<texture*>::iterator it = _pages.begin();
+  for(; it != _pages.end(); ++it) {
+    delete *it;
+  }
+  _pages.clear();
+  for(int i = 0; i < 256; ++i) {
+    _glyphs[i].page = -1;
+    _glyphs[i].clip = rect();
+    _glyphs[i].xoffset = 0;
+    _glyphs[i].yoffset = 0;
+    _advance[i] = 0;
+  }
+  _height = 0;
+  _kerning = false;
+  _kerning_pairs.clear();
+}
+
+std::string bitmap_font::tostr() const
+{
+  std::stringstream ss;
+  ss << "bitmap_font< " << _fname \
+     << ", pts=" << _pts << ">";
+  return ss.str();
+}
+
+void bitmap_font::load(const std::string & file_path)
+{
+  std::ifstream f(media_path(file_path).c_str(), std::ios::binary);
+  if (!f) {
+    SDL_Log("%s - failed to open %s", __METHOD_NAME__, file_path.c_str());
+    throw std::runtime_error("Failed to open bitmap font");
+  }
+  std::string data((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+  load(file_path, data.c_str(), data.length());
+}
+
+void bitmap_font::load(const std::string & name, const char * data, size_t size)
+{
+  clear();
+  _fname = name;
+  std::string folder = path(name).parent_path().generic_string();
+
+  std::stringstream ss(std::string(data, size));
+  std::string line;
+  fnt_attrs attrs;
+  while (std::getline(ss, line)) {
+    std::string tag = parse_fnt_line(line, attrs);
+    if (tag == "info") {
+      // negative size means it matches char height
+      _pts = (size_t)abs(fnt_int(attrs, "size"));
+    }
+    else if (tag == "common") {
+      _height = fnt_int(attrs, "lineHeight");
+      _base = fnt_int(attrs, "base");
+      _page_w = fnt_int(attrs, "scaleW");
+      _page_h = fnt_int(attrs, "scaleH");
+    }
+    else if (tag == "page") {
+      size_t id = (size_t)fnt_int(attrs, "id");
+      if (_pages.size() <= id)
+        _pages.resize(id + 1, NULL);
+      std::string file = attrs["file"];
+      delete _pages[id];
+      _pages[id] = new texture(folder.empty() ? file : folder + "/" + file);
+    }
+    else if (tag == "char") {
+      int id = fnt_int(attrs, "id");
+      if (id < 0 || id > 255)
+        continue;
+      glyph & g = _glyphs[id];
+      g.page = fnt_int(attrs, "page");
+      g.clip = rect(fnt_int(attrs, "x"), fnt_int(attrs, "y"),
+                    fnt_int(attrs, "width"), fnt_int(attrs, "height"));
+      g.xoffset = fnt_int(attrs, "xoffset");
+      g.yoffset = fnt_int(attrs, "yoffset");
+      _advance[id] = fnt_int(attrs, "xadvance");
+    }
+    else if (tag == "kerning") {
+      int first = fnt_int(attrs, "first");
+      int second = fnt_int(attrs, "second");
+      if (first < 0 || first > 255 || second < 0 || second > 255)
+        continue;
+      // all pairs are known, nothing is fetched lazily
+      if (_kerning_pairs.empty())
+        _kerning_pairs.resize(256 * 256, 0);
+      _kerning_pairs[first * 256 + second] = (int16_t)fnt_int(attrs, "amount");
+      _kerning = true;
+    }
+  }
+
+  for(int i = 0; i < 256; ++i) {
+    glyph & g = _glyphs[i];
+    if (g.page >= (int)_pages.size() || (g.page >= 0 && _pages[g.page] == NULL)) {
+      SDL_Log("%s - glyph %d of %s refers to missing page %d",
+        __METHOD_NAME__, i, name.c_str(), g.page);
+      throw std::runtime_error("Bitmap font glyph refers to missing page");
+    }
+  }
+  if (_pages.empty()) {
+    SDL_Log("%s - %s has no pages", __METHOD_NAME__, name.c_str());
+    throw std::runtime_error("Bitmap font has no pages");
+  }
+  if (_page_w == 0 || _page_h == 0) {
+    _page_w = _pages[0]->width();
+    _page_h = _pages[0]->height();
+  }
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+  _batches.assign(_pages.size(), std::vector<SDL_Vertex>());
+#endif
+  SDL_Log("bitmap_font - loaded %s, pt size: %zu",
+          _fname.c_str(), _pts);
+}
+
+void bitmap_font::render_text(SDL_Renderer * r, const std::string & text,
+                              const point & at, const color & clr,
+                              bool) const
+{
+  if (text.empty() || _pages.empty())
+    return;
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+  for(size_t p = 0; p < _batches.size(); ++p)
+    _batches[p].clear();
+
+  float x = (float)at.x;
+  float y = (float)at.y;
+  float pw = (float)_page_w;
+  float ph = (float)_page_h;
+  uint8_t prev = 0;
+  for(size_t i = 0; i < text.length(); ++i) {
+    uint8_t ch = (uint8_t)text[i];
+    const glyph & g = _glyphs[ch];
+    x += kerning(prev, ch);
+    prev = ch;
+    if (g.page >= 0 && g.clip.w > 0 && g.clip.h > 0) {
+      float x0 = x + g.xoffset;
+      float y0 = y + g.yoffset;
+      float u0 = g.clip.x / pw;
+      float v0 = g.clip.y / ph;
+      float u1 = (g.clip.x + g.clip.w) / pw;
+      float v1 = (g.clip.y + g.clip.h) / ph;
+      SDL_Vertex quad[4];
+      quad[0].position.x = x0;             quad[0].position.y = y0;
+      quad[1].position.x = x0 + g.clip.w;  quad[1].position.y = y0;
+      quad[2].position.x = x0 + g.clip.w;  quad[2].position.y = y0 + g.clip.h;
+      quad[3].position.x = x0;             quad[3].position.y = y0 + g.clip.h;
+      quad[0].tex_coord.x = u0; quad[0].tex_coord.y = v0;
+      quad[1].tex_coord.x = u1; quad[1].tex_coord.y = v0;
+      quad[2].tex_coord.x = u1; quad[2].tex_coord.y = v1;
+      quad[3].tex_coord.x = u0; quad[3].tex_coord.y = v1;
+      quad[0].color = quad[1].color = quad[2].color = quad[3].color = clr;
+      _batches[g.page].insert(_batches[g.page].end(), quad, quad + 4);
+    }
+    x += _advance[ch];
+  }
+
+  // one draw call per page, indices are shared by all batches
+  for(size_t p = 0; p < _batches.size(); ++p) {
+    std::vector<SDL_Vertex> & batch = _batches[p];
+    if (batch.empty())
+      continue;
+    size_t quads = batch.size() / 4;
+    for(size_t q = _indices.size() / 6; q < quads; ++q) {
+      int v = (int)q * 4;
+      int idx[6] = { v, v + 1, v + 2, v, v + 2, v + 3 };
+      _indices.insert(_indices.end(), idx, idx + 6);
+    }
+    if (SDL_RenderGeometry(r, _pages[p]->get_texture(),
+                           &batch[0], (int)batch.size(),
+                           &_indices[0], (int)quads * 6) != 0)
+      throw sdl_exception();
+  }
+#else
+  std::vector<texture*>::const_iterator it = _pages.begin();
+  for(; it != _pages.end(); ++it) {
+    (*it)->set_color_mod(clr);
+    (*it)->set_alpha(clr.a);
+  }
+  int x = at.x;
+  uint8_t prev = 0;
+  for(size_t i = 0; i < text.length(); ++i) {
+    uint8_t ch = (uint8_t)text[i];
+    const glyph & g = _glyphs[ch];
+    x += kerning(prev, ch);
+    prev = ch;
+    if (g.page >= 0 && g.clip.w > 0 && g.clip.h > 0)
+      _pages[g.page]->render(r, g.clip,
+        rect(x + g.xoffset, at.y + g.yoffset, g.clip.w, g.clip.h));
+    x += _advance[ch];
+  }
+#endif
+}
@@ -9,12 +9,14 @@ static const char * DRAG_STATE_NAME[] = {
 
 namespace ui {
 
+// boxes waiting for the layout pass
+static container<box*> g_layout_queue;
+
 /** UI BOX Container Implementation **/
 
 box::box(const rect & pos, const box_type & t, const h_align & ha, const v_align & va, const padding & pad, const int & margin):
   control(pos),
   _type(t), _ha(ha), _va(va),
-  _dirty(false),
   _pad(pad),
   _children_rect(0, 0, _pad.top, _pad.left),
   _margin(margin),
@@ -22,11 +24,68 @@ box::box(const rect & pos, const box_type & t, const h_align & ha, const v_align
   _hscroll(nullptr),
   _scroll_type(scroll_type::scrollbar_hidden),
   _scroll_size(20),
-  _selected_ctl(nullptr)
+  _selected_ctl(nullptr),
+  _wrap(false),
+  _layout_requested(false),
+  _update_depth(0)
 {
   mouse_wheel += boost::bind(&box::on_box_wheel, this, _1);
 }
 
+box::~box()
+{
+  if (_vscroll != nullptr) {
+    remove_child(_vscroll);
+    ui::destroy(_vscroll);
+  }
+  if (_hscroll != nullptr) {
+    remove_child(_hscroll);
+    ui::destroy(_hscroll);
+  }
+  // may be queued even if it was laid out directly since
+  g_layout_queue.remove(this);
+}
+
+void box::request_layout()
+{
+  if (_layout_requested)
+    return;
+  _layout_requested = true;
+  g_layout_queue.push_back(this);
+}
+
+void box::begin_update()
+{
+  ++_update_depth;
+}
+
+void box::end_update()
+{
+  if (_update_depth == 0) {
+    SDL_Log("%s - end_update without begin_update", __METHOD_NAME__);
+    throw std::runtime_error("Unbalanced box end_update");
+  }
+  if (--_update_depth == 0 && _layout_requested)
+    update_children();
+}
+
+void box::layout_pending()
+{
+  lock_container(g_layout_queue);
+  // a layout can request others, i.e. of nested boxes
+  while (g_layout_queue.size() > 0) {
+    std::vector<box*> pending;
+    pending.swap(g_layout_queue.get());
+    std::vector<box*>::iterator it = pending.begin();
+    for(; it != pending.end(); ++it) {
+      box * b = *it;
+      // batched boxes are laid out by their end_update
+      if (b->_layout_requested && b->_update_depth == 0)
+        b->update_children();
+    }
+  }
+}
+
 void box::set_scroll_type(scroll_type t, int ssize)
 {
   _scroll_type = t;
@@ -81,7 +140,7 @@ void box::update()
 {
   const point & pointer = manager::instance()->get_pointer();
   if (_vscroll != nullptr) {
-    _vscroll->set_pos(get_vscroll_rect());
+    _vscroll->arrange(get_vscroll_rect());
 
     if ( !(_vscroll->pos() + _pos.topleft()).collide_point(pointer)
          && get_scroll_state() == scroll_drag_state::vdrag ) {
@@ -90,7 +149,7 @@ void box::update()
 
   }
   if (_hscroll != nullptr) {
-    _hscroll->set_pos(get_hscroll_rect());
+    _hscroll->arrange(get_hscroll_rect());
 
     if ( !(_hscroll->pos() + _pos.topleft()).collide_point(pointer)
          && get_scroll_state() == scroll_drag_state::hdrag ) {
@@ -108,6 +167,8 @@ void box::draw(SDL_Renderer * r, const rect & dst)
 
   /** scrolled children rendering **/
   lock_container(_children);
+  // dst is not the absolute position while drawing into the cache
+  point origin = dst.topleft() - get_absolute_pos().topleft();
   control_list::iterator it = _children.begin();
   {
     texture::clip_context clip(r, dst);
@@ -115,19 +176,19 @@ void box::draw(SDL_Renderer * r, const rect & dst)
       control * c = *it;
       if (c->destroyed() || !c->visible() || c == _vscroll || c == _hscroll)
         continue;
-      rect child_pos = c->get_absolute_pos();
+      rect child_pos = c->get_absolute_pos() + origin;
       if (!child_pos.collide_rect(dst))
         continue;
-      c->draw(r, child_pos);
+      c->render_at(r, child_pos);
     }
   }
 
   // render scrollbars
   if (_vscroll && _scroll_type & scroll_type::scrollbar_vertical) {
-    _vscroll->draw(r, _vscroll->pos() + dst.topleft());
+    _vscroll->render_at(r, _vscroll->pos() + dst.topleft());
   }
   if (_hscroll && _scroll_type & scroll_type::scrollbar_horizontal) {
-    _hscroll->draw(r, _hscroll->pos() + dst.topleft());
+    _hscroll->render_at(r, _hscroll->pos() + dst.topleft());
   }
 
   /** hovered box **/
@@ -165,14 +226,14 @@ void box::clear_children()
     _children.clear();
   }
 
-  update_children();
+  invalidate_measure();
 }
 
 void box::remove_child(control * c)
 {
-  // remove and update children
+  // remove and update children later
   control::remove_child(c);
-  update_children();
+  invalidate_measure();
 }
 
 void box::add_child(control* c)
@@ -184,7 +245,7 @@ void box::add_child(control* c)
   c->mouse_wheel += boost::bind( &box::on_child_wheel, this, _1 );
   
   control::add_child(c);
-  update_children();
+  invalidate_measure();
 }
 
 void box::on_box_wheel(control * target)
@@ -202,7 +263,7 @@ void box::on_child_wheel(control * target)
 void box::on_child_hover_changed(control * target)
 {
   // rebuild on child hover change
-  _dirty = true;
+  invalidate();
 }
 
 void box::on_child_click(control * target)
@@ -281,6 +342,9 @@ void box::load(const json & d)
 
   if (d.find("margin") != d.end() && d["margin"].is_number())
     _margin = d["margin"];
+
+  if (d.find("wrap") != d.end())
+    set_wrap(d["wrap"]);
 }
 
 void box::switch_selection(control * target)
@@ -293,7 +357,7 @@ void box::switch_selection(control * target)
   if (_selected_ctl != NULL)
     _selected_ctl->selection_change(_selected_ctl);
   // rebuild on selection change
-  _dirty = true;
+  invalidate();
 }
 
 void box::do_scroll(int dx, int dy)
@@ -313,6 +377,10 @@ void box::do_scroll(int dx, int dy)
   if (_scroll_type && scroll_type::scrollbar_horizontal) {
     /* FIXME !!! */
   }
+
+  // scrolled children moved on the screen
+  invalidate_children_geometry();
+  invalidate();
 }
 
 std::string box::get_box_type_name() const
@@ -329,164 +397,222 @@ std::string box::get_box_type_name() const
   };
 }
 
+/* child of a box, main is the side along the box direction */
+struct flex_item {
+  control * cnt;
+  int main, cross;
+  int min_main, max_main;
+  int min_cross, max_cross;
+  int grow, shrink;
+  bool frozen;
+};
+
+/* grow or shrink items of a line by their weights to take the free
+   space, items reaching a limit are frozen and the rest split again */
+static void flex_line(std::vector<flex_item> & items, size_t from, size_t to, int free)
+{
+  for(size_t i = from; i < to; ++i)
+    items[i].frozen = false;
+
+  while (free != 0) {
+    long long total = 0;
+    for(size_t i = from; i < to; ++i) {
+      const flex_item & it = items[i];
+      if (!it.frozen)
+        total += free > 0 ? it.grow : (long long)it.shrink * it.main;
+    }
+    if (total == 0)
+      break;
+
+    int spent = 0;
+    for(size_t i = from; i < to; ++i) {
+      flex_item & it = items[i];
+      long long weight = free > 0 ? it.grow : (long long)it.shrink * it.main;
+      if (it.frozen || weight == 0)
+        continue;
+      int target = it.main + (int)(free * weight / total);
+      if (target < it.min_main) {
+        target = it.min_main;
+        it.frozen = true;
+      }
+      if (it.max_main > 0 && target > it.max_main) {
+        target = it.max_main;
+        it.frozen = true;
+      }
+      spent += target - it.main;
+      it.main = target;
+    }
+    // rounding leftover is not split
+    if (spent == 0)
+      break;
+    free -= spent;
+  }
+}
+
+static bool is_laid_out(const control * child, const control * vscroll, const control * hscroll)
+{
+  return !child->locked() && child->visible() &&
+    child != vscroll && child != hscroll;
+}
+
+point box::measure_content()
+{
+  lock_container(_children);
+  int main = 0, cross = 0;
+  int w = 0, h = 0;
+  control_list::iterator it = _children.begin();
+  for(; it != _children.end(); ++it) {
+    control * child = *it;
+    if (!is_laid_out(child, _vscroll, _hscroll))
+      continue;
+    if (_type == box::none) {
+      // children keep their positions
+      w = max(w, child->pos().x + child->pos().w);
+      h = max(h, child->pos().y + child->pos().h);
+      continue;
+    }
+    point m = child->measure();
+    bool vertical = (_type == box::vbox);
+    main += _margin + (vertical ? m.y : m.x);
+    cross = max(cross, vertical ? m.x : m.y);
+  }
+  if (_type == box::vbox) {
+    w = cross;
+    h = main;
+  }
+  if (_type == box::hbox) {
+    w = main;
+    h = cross;
+  }
+  return point(_pad.left + w + _pad.right, _pad.top + h + _pad.bottom);
+}
+
+void box::layout_invalidated()
+{
+  request_layout();
+}
+
 void box::update_children()
 {
   lock_container(_children);
+  _layout_requested = false;
 
-  // get available area for children
-  // all box rect is available by default
-  rect area(0, 0, _pos.w, _pos.h);
+  if (_type != box::none && _type != box::vbox && _type != box::hbox) {
+    SDL_Log("%s - unknown box type value \"%d\"", __METHOD_NAME__, _type);
+    throw std::runtime_error("Unknown box type value");
+  }
 
   // minimum size
   _children_rect.w = _pad.left + _pad.right;
   _children_rect.h = _pad.top + _pad.bottom;
 
-  // last positioned control 
-  rect last_pos;
+  // vbox stacks children along y, hbox along x
+  bool vertical = (_type == box::vbox);
+  int main_size = vertical ? _pos.h : _pos.w;
+  int cross_size = vertical ? _pos.w : _pos.h;
+  int pad_start = vertical ? _pad.top : _pad.left;
+  int pad_end = vertical ? _pad.bottom : _pad.right;
+  int cross_start = vertical ? _pad.left : _pad.top;
+  int cross_end = vertical ? _pad.right : _pad.bottom;
+  // stacked from the bottom or right side
+  bool reverse = vertical ? (_va == v_align::bottom) : (_ha == h_align::right);
+  // alignment across, middle and fill are ignored along
+  bool align_end = vertical ? (_ha == h_align::right) : (_va == v_align::bottom);
+  bool align_center = vertical ? (_ha == h_align::center) : (_va == v_align::middle);
+  bool stretch = vertical ? (_ha == h_align::expand) : (_va == v_align::fill);
+
+  std::vector<flex_item> items;
+  items.reserve(_children.size());
   control_list::iterator it = _children.begin();
   for(; it != _children.end(); ++it) {
     control* child = (*it);
-    
-    // skip locked children of this box
-    if (child->locked())
+    if (!is_laid_out(child, _vscroll, _hscroll))
       continue;
-    // skip hidden
-    if (!child->visible())
-      continue;
-    // skip scrollbars
-    if (child == _vscroll || child == _hscroll)
-        continue;
-    
-    rect pos = child->pos();
-    switch(_type) {
 
-    case box::none:
+    if (_type == box::none) {
       // take control size of it is less then area
-      _children_rect.w = max(_pad.left + pos.x + pos.w + _pad.right, area.w);
-      _children_rect.h = max(_pad.top + pos.y + pos.h + _pad.bottom, area.h);
-      break;
+      rect pos = child->pos();
+      _children_rect.w = max(_pad.left + pos.x + pos.w + _pad.right, _pos.w);
+      _children_rect.h = max(_pad.top + pos.y + pos.h + _pad.bottom, _pos.h);
+      continue;
+    }
 
-    case box::vbox:
-      {
-        switch(_ha) {
-        default:
-          SDL_Log("%s - unsupported h_align value \"%d\" for vbox",
-            __METHOD_NAME__, _ha);
-          throw std::runtime_error("Unsupported h_align value for vbox");
-
-        case h_align::left:
-          // position child on the left side of the vbox
-          pos.x = area.x + _pad.left;
-          break;
-
-        case h_align::right:
-          // position child on the right side of the vbox
-          pos.x = area.x + area.w - _pad.right - pos.w;
-          break;
-
-        case h_align::center:
-          // position child in the center of the vbox
-          pos.x = area.x + (area.w - pos.w) / 2;
-          break;
-
-        case h_align::expand:
-          SDL_Log("FIXME");
-          break;
-        };
-
-        switch(_va) {
-        default:
-          SDL_Log("%s - unsupported v_align value \"%d\" for vbox",
-            __METHOD_NAME__, _ha);
-          throw std::runtime_error("Unsupported v_align value for vbox");
-
-        // ignore middle and fill in v_align for vbox
-        // default to the top
-        case v_align::middle:
-        case v_align::fill:
-        case v_align::top:
-          // append from the top
-          if (last_pos.y == 0)
-            last_pos.y = area.y + _pad.top;
-          pos.y = last_pos.y + last_pos.h + _margin;
-          break;
-
-        case v_align::bottom:
-          // append at the bottom
-          if (last_pos.y == 0)
-            last_pos.y = area.y + area.h - _pad.bottom;
-          pos.y = last_pos.y - _margin - pos.h;
-          break;
-        }; 
-      }
-      break;
+    point m = child->measure();
+    const point & lo = child->get_min_size();
+    const point & hi = child->get_max_size();
+    flex_item item;
+    item.cnt = child;
+    item.main = vertical ? m.y : m.x;
+    item.cross = vertical ? m.x : m.y;
+    item.min_main = vertical ? lo.y : lo.x;
+    item.max_main = vertical ? hi.y : hi.x;
+    item.min_cross = vertical ? lo.x : lo.y;
+    item.max_cross = vertical ? hi.x : hi.y;
+    item.grow = child->get_grow();
+    item.shrink = child->get_shrink();
+    items.push_back(item);
+  }
 
-    case box::hbox:
-      {
-        switch(_va) {
-        default:
-          SDL_Log("%s - unsupported v_align value \"%d\" for hbox",
-            __METHOD_NAME__, _ha);
-          throw std::runtime_error("Unsupported v_align value for hbox");
-
-        case v_align::top:
-          // position child at the top of the hbox
-          pos.y = area.y + _pad.top;
-          break;
-
-        case v_align::bottom:
-          // position child at the bottom of the hbox
-          pos.y = area.y + area.h - _pad.bottom - pos.h;
-          break;
-
-        case v_align::middle:
-          // position child in he center of the hbox
-          pos.y = area.y + (area.h - pos.h) / 2;
-          break;
-
-        case v_align::fill:
-          SDL_Log("FIXME");
-          break;
-        };
-        
-        switch(_ha) {
-        default:
-          SDL_Log("%s - unsupported h_align value \"%d\" for hbox",
-            __METHOD_NAME__, _ha);
-          throw std::runtime_error("Unsupported h_align value for hbox");
-
-        // ignore center and expand in h_align for hbox
-        // 
-        case h_align::center:
-        case h_align::expand:
-        case h_align::left:
-          if (last_pos.x == 0)
-            last_pos.x = area.x + _pad.left;
-          pos.x = last_pos.x + last_pos.w + _margin;
-          break;
-
-        case h_align::right:
-          if (last_pos.x == 0)
-            last_pos.x = area.x + area.w - _pad.right;
-          pos.x = last_pos.x - _margin - pos.w;
-
-          break;
-        };
+  int avail = main_size - pad_start - pad_end;
+  int line_pos = cross_start;
+  size_t from = 0;
+  while (from < items.size()) {
+    // children up to the one not fitting, all of them without wrap
+    size_t to = from;
+    int used = 0;
+    while (to < items.size()) {
+      int next = used + _margin + items[to].main;
+      if (_wrap && to > from && next > avail)
+        break;
+      used = next;
+      ++to;
+    }
+    flex_line(items, from, to, avail - used);
+
+    // the whole box across without wrap, the widest child of a line with it
+    int line_size = cross_size - cross_start - cross_end;
+    if (_wrap) {
+      line_size = 0;
+      for(size_t i = from; i < to; ++i)
+        line_size = max(line_size, items[i].cross);
+    }
+
+    int cursor = reverse ? main_size - pad_end : pad_start;
+    for(size_t i = from; i < to; ++i) {
+      flex_item & item = items[i];
+      int main_pos = 0;
+      if (reverse) {
+        cursor -= _margin + item.main;
+        main_pos = cursor;
+      }
+      else {
+        main_pos = cursor + _margin;
+        cursor = main_pos + item.main;
       }
-      break;
-    default:
-      SDL_Log("%s - unknown box type value \"%d\"", __METHOD_NAME__, _type);
-      throw std::runtime_error("Unknown box type value");
-      break;
-    };
 
-    // update child position (rect) & remember it
-    child->set_pos(pos);
-    last_pos = pos;
+      if (stretch) {
+        item.cross = max(line_size, item.min_cross);
+        if (item.max_cross > 0)
+          item.cross = min(item.cross, item.max_cross);
+      }
+      int cross_pos = line_pos;
+      if (align_end)
+        cross_pos = line_pos + line_size - item.cross;
+      else if (align_center)
+        cross_pos = line_pos + (line_size - item.cross) / 2;
+
+      rect pos = vertical ?
+        rect(cross_pos, main_pos, item.cross, item.main) :
+        rect(main_pos, cross_pos, item.main, item.cross);
+      item.cnt->arrange(pos);
+
+      // update total width & height
+      _children_rect.w = max(_children_rect.w, pos.x + pos.w);
+      _children_rect.h = max(_children_rect.h, pos.y + pos.h);
+    }
 
-    // update total width & height
-    _children_rect.w = max(_children_rect.w, last_pos.x + last_pos.w);
-    _children_rect.h = max(_children_rect.h, last_pos.y + last_pos.h);
+    line_pos += line_size + _margin;
+    from = to;
   }
 
   // normalize children rect
@@ -508,10 +634,16 @@ void box::update_children()
     _children.push_back(_hscroll);
   }
 
-  // rebuild on children add/remove/show/hide/reorder
-  _scrolled_rect.x = 0;
-  _scrolled_rect.y = 0;
-  _dirty = true;
+  // keep the scroll offset within the new children rect
+  _scrolled_rect.x = min(_scrolled_rect.x, _children_rect.w - _scrolled_rect.w);
+  _scrolled_rect.y = min(_scrolled_rect.y, _children_rect.h - _scrolled_rect.h);
+  if (_scrolled_rect.x < 0)
+    _scrolled_rect.x = 0;
+  if (_scrolled_rect.y < 0)
+    _scrolled_rect.y = 0;
+  invalidate_children_geometry();
+  layout_changed();
+  invalidate();
 }
 
 /**
@@ -4,6 +4,19 @@ namespace ui {
 
 #define CONTROL_ID_LEN 5
 
+// changes of the layout of all controls
+static uint32_t g_layout_gen = 1;
+
+void control::layout_changed()
+{
+  ++g_layout_gen;
+}
+
+uint32_t control::layout_generation()
+{
+  return g_layout_gen;
+}
+
 /** Control **/
 
 // regular control constructor. manager is a parent by default
@@ -13,7 +26,14 @@ control::control(const rect & pos):
   _scrolled_rect(0, 0, pos.w, pos.h),
   _visible(true), _proxy(false), _locked(false), 
   _destroyed(false), _disabled(false),
-  _id(rand_string(CONTROL_ID_LEN))
+  _id(rand_string(CONTROL_ID_LEN)),
+  _indexed(false),
+  _cache_render(false),
+  _cache_stale(true),
+  _cached_gen(0), _geometry_gen(1),
+  _basis(_pos.w, _pos.h),
+  _grow(0), _shrink(0),
+  _measure_valid(false)
   
 {
   manager::instance()->add_child(this);
@@ -25,7 +45,14 @@ control::control(const rect & pos, const std::string id):
   _scrolled_rect(0, 0, pos.w, pos.h),
   _visible(true), _proxy(false), _locked(false), 
   _destroyed(false), _disabled(false),
-  _id(id)
+  _id(id),
+  _indexed(false),
+  _cache_render(false),
+  _cache_stale(true),
+  _cached_gen(0), _geometry_gen(1),
+  _basis(_pos.w, _pos.h),
+  _grow(0), _shrink(0),
+  _measure_valid(false)
 {
   manager::instance()->add_child(this);
 }
@@ -36,7 +63,14 @@ control::control():
   _scrolled_rect(GM_GetDisplayRect()),
   _visible(true), _proxy(false), _locked(false), 
   _destroyed(false), _disabled(false),
-  _id("root")
+  _id("root"),
+  _indexed(false),
+  _cache_render(false),
+  _cache_stale(true),
+  _cached_gen(0), _geometry_gen(1),
+  _basis(_pos.w, _pos.h),
+  _grow(0), _shrink(0),
+  _measure_valid(false)
 {
   SDL_Log("ui::manager - initialized %s",
     _pos.tostr().c_str());
@@ -50,6 +84,7 @@ control::~control()
     control * child = *it;
     delete child;
   }
+  manager::unindex(this);
 }
 
 std::string control::tostr() const
@@ -83,15 +118,99 @@ std::string control::tostr() const
 void control::load(const json & d)
 {
   if (d.find("id") != d.end())
-    _id = d["id"];
+    set_identifier(d["id"]);
   if (d.find("visible") != d.end())
     _visible = d["visible"];
   if (d.find("proxy") != d.end())
     _proxy = d["proxy"];
+  if (d.find("cached") != d.end())
+    set_render_cache(d["cached"]);
+  if (d.find("grow") != d.end() && d["grow"].is_number())
+    set_flex(d["grow"].get<int>(), _shrink);
+  if (d.find("shrink") != d.end() && d["shrink"].is_number())
+    set_flex(_grow, d["shrink"].get<int>());
+  if (d.find("min_size") != d.end() && d["min_size"].is_array())
+    set_min_size(point(d["min_size"].at(0), d["min_size"].at(1)));
+  if (d.find("max_size") != d.end() && d["max_size"].is_array())
+    set_max_size(point(d["max_size"].at(0), d["max_size"].at(1)));
 }
 
-rect control::get_absolute_pos() const
+void control::arrange(const rect & r)
+{
+  if (r == _pos) return;
+  bool resized = (r.w != _pos.w || r.h != _pos.h);
+  // damage both the old and the new area
+  invalidate();
+  _pos = r;
+  invalidate_geometry();
+  invalidate();
+  if (resized)
+    layout_invalidated();
+}
+
+point control::measure_content()
+{
+  return point(0, 0);
+}
+
+point control::measure()
+{
+  if (_measure_valid)
+    return _measured;
+  point m = _basis;
+  if (auto_sized()) {
+    point content = measure_content();
+    if (m.x <= 0) m.x = content.x;
+    if (m.y <= 0) m.y = content.y;
+  }
+  m.x = max(m.x, _min_size.x);
+  m.y = max(m.y, _min_size.y);
+  if (_max_size.x > 0) m.x = min(m.x, _max_size.x);
+  if (_max_size.y > 0) m.y = min(m.y, _max_size.y);
+  _measured = m;
+  _measure_valid = true;
+  return m;
+}
+
+void control::invalidate_measure()
 {
+  // parents measured since are valid again, the ones still
+  // stale were told already. measure of a control with fixed
+  // preferred size does not depend on the children
+  for(control * c = this; c != NULL; c = c->_parent) {
+    bool was_valid = c->_measure_valid;
+    c->_measure_valid = false;
+    c->layout_invalidated();
+    if (c != this && (!was_valid || !c->auto_sized()))
+      break;
+  }
+}
+
+void control::set_flex(int grow, int shrink)
+{
+  if (grow == _grow && shrink == _shrink) return;
+  _grow = max(grow, 0);
+  _shrink = max(shrink, 0);
+  invalidate_measure();
+}
+
+void control::set_min_size(const point & sz)
+{
+  _min_size = sz;
+  invalidate_measure();
+}
+
+void control::set_max_size(const point & sz)
+{
+  _max_size = sz;
+  invalidate_measure();
+}
+
+void control::update_geometry() const
+{
+  if (_cached_gen == _geometry_gen)
+    return;
+
   if (_parent != NULL) {
     rect parent_rect = _parent->get_absolute_pos();
     rect pos = _pos + parent_rect.topleft();
@@ -99,16 +218,62 @@ rect control::get_absolute_pos() const
     // unless they are locked in position
     if (!locked())
       pos = pos - _parent->get_scrolled_rect().topleft();
-    // absolute pos is a visible part of the control (within parent's rect)
-    pos.clip(parent_rect);
-    return pos;
+    _abs_pos = pos;
+    // visible part of the control is within visible part of the parent
+    rect parent_visible = _parent->get_visible_rect();
+    if (SDL_IntersectRect(&pos, &parent_visible, &_visible_rect) != SDL_TRUE)
+      _visible_rect = rect(pos.x, pos.y, 0, 0);
+  }
+  else {
+    _abs_pos = _pos;
+    _visible_rect = _pos;
   }
-  return _pos;
+  _cached_gen = _geometry_gen;
+}
+
+rect control::get_absolute_pos() const
+{
+  update_geometry();
+  return _abs_pos;
+}
+
+rect control::get_visible_rect() const
+{
+  update_geometry();
+  return _visible_rect;
+}
+
+void control::invalidate_geometry()
+{
+  // children of a stale control are stale already, since
+  // their rects are computed from the parent's ones
+  if (_cached_gen != _geometry_gen)
+    return;
+  ++_geometry_gen;
+  layout_changed();
+  invalidate_children_geometry();
+}
+
+void control::invalidate_children_geometry()
+{
+  lock_container(_children);
+  control_list::iterator it = _children.begin();
+  for(; it != _children.end(); ++it)
+    (*it)->invalidate_geometry();
+}
+
+void control::set_identifier(const std::string & id)
+{
+  if (_indexed)
+    manager::rename_indexed(this, id);
+  else
+    _id = id;
 }
 
 void control::set_parent(control* parent)
 {
   _parent = parent;
+  invalidate_geometry();
 }
 
 size_t control::find_child_index(const control * c)
@@ -143,7 +308,7 @@ control * control::find_child_at(const point & at)
     control_list::reverse_iterator it = _children.rbegin();
     for(; it != _children.rend(); ++it) {
       control * child = *it;
-      if (!child->destroyed() && child->visible() && child->get_absolute_pos().collide_point(at) )
+      if (!child->destroyed() && child->visible() && child->get_visible_rect().collide_point(at) )
         return child->find_child_at(at);
     }
   }
@@ -153,7 +318,7 @@ control * control::find_child_at(const point & at)
     return NULL;
   
   // if control didnt find any children and itself matches, return it
-  if (get_absolute_pos().collide_point(at)) {
+  if (get_visible_rect().collide_point(at)) {
     return this;
   }
   // nothing at all
@@ -182,6 +347,11 @@ void control::add_child(control* child)
       child->parent()->remove_child(child);
     }
     child->set_parent(this);
+    if (_indexed)
+      manager::index_tree(child);
+    layout_changed();
+    // only the area of the child is damaged
+    child->invalidate();
   }
 }
 
@@ -190,7 +360,11 @@ void control::remove_child(control* child)
   lock_container(_children);
   control_list::iterator it = find_child(child);
   if (it != _children.end()) {
+    // damage the area of the child while it is still placed
+    child->invalidate();
     _children.erase(it);
+    manager::unindex_tree(child);
+    layout_changed();
   }
 }
 
@@ -207,6 +381,10 @@ void control::insert_child(size_t idx, control * c)
 {
   lock_container(_children);
   _children.insert(_children.begin() + idx, c);
+  if (_indexed)
+    manager::index_tree(c);
+  layout_changed();
+  invalidate();
 }
 
 void control::draw(SDL_Renderer* r, const rect & dst)
@@ -215,13 +393,62 @@ void control::draw(SDL_Renderer* r, const rect & dst)
     return;
 
   lock_container(_children);
+  // dst is not the absolute position while drawing into the cache
+  point origin = dst.topleft() - get_absolute_pos().topleft();
   control_list::iterator it = _children.begin();
   for(; it != _children.end(); ++it) {
     control * c = *it;
     if (c->destroyed() || !c->visible()) continue;
-    rect control_dst = c->get_absolute_pos();
-    c->draw(r, control_dst);
+    rect control_dst = c->get_absolute_pos() + origin;
+    c->render_at(r, control_dst);
+  }
+}
+
+void control::render_at(SDL_Renderer* r, const rect & dst)
+{
+  if (!_cache_render) {
+    draw(r, dst);
+    return;
+  }
+  if (dst.w <= 0 || dst.h <= 0)
+    return;
+
+  if (!_cache.is_valid() || _cache.width() != dst.w || _cache.height() != dst.h) {
+    _cache.blank(dst.w, dst.h, SDL_TEXTUREACCESS_TARGET);
+    _cache_stale = true;
+  }
+  if (_cache_stale) {
+    // the frame is not complete yet, so no present
+    texture::render_context ctx(&_cache, r, false);
+    SDL_SetRenderDrawColor(r, 0, 0, 0, 0);
+    SDL_RenderClear(r);
+    draw(r, rect(0, 0, dst.w, dst.h));
+    _cache_stale = false;
+  }
+  _cache.render(r, dst);
+}
+
+void control::set_render_cache(bool c)
+{
+  if (c == _cache_render)
+    return;
+  _cache_render = c;
+  _cache_stale = true;
+  if (!c)
+    _cache.release();
+  invalidate();
+}
+
+void control::invalidate()
+{
+  // no early exit on a stale parent, one of its parents
+  // could have been drawn while it was hidden
+  for(control * c = this; c != NULL; c = c->_parent) {
+    if (c->_cache_render)
+      c->_cache_stale = true;
   }
+  if (GM_GetPartialRedraw())
+    GM_AddDamage(get_visible_rect());
 }
 
 void control::update()
@@ -0,0 +1,163 @@
+#include "engine.h"
+#include "manager.h"
+#include "sdl_ex.h"
+
+#include "bench.h"
+
+static double elapsed_ms(Uint64 start)
+{
+  return (double)(SDL_GetPerformanceCounter() - start) * 1000.0 /
+    (double)SDL_GetPerformanceFrequency();
+}
+
+/** find_child **/
+
+static const int tree_fanout = 8;
+
+static std::string control_id(int i)
+{
+  std::stringstream ss;
+  ss << "ctl-" << i;
+  return ss.str();
+}
+
+static double time_lookups(ui::control * root, int controls, int lookups)
+{
+  int missed = 0;
+  Uint64 start = SDL_GetPerformanceCounter();
+  for(int i = 0; i < lookups; ++i) {
+    // spread over the tree, late ones are the worst case of the search
+    int idx = (int)(((long long)i * 7919) % controls);
+    if (root->find_child(control_id(idx)) == NULL)
+      ++missed;
+  }
+  double ms = elapsed_ms(start);
+  if (missed > 0)
+    printf("bench: find_child missed %d controls\n", missed);
+  return ms;
+}
+
+void bench_find_child(int controls, int lookups)
+{
+  // complete tree, the parent of control N is (N - 1) / fanout
+  std::vector<ui::control*> nodes;
+  nodes.reserve(controls);
+  for(int i = 0; i < controls; ++i) {
+    ui::control * c = new ui::control(rect(0, 0, 10, 10), control_id(i));
+    if (i > 0)
+      nodes[(i - 1) / tree_fanout]->add_child(c);
+    nodes.push_back(c);
+  }
+  ui::control * root = nodes[0];
+
+  double dfs = time_lookups(root, controls, lookups);
+
+  ui::manager * mgr = ui::manager::instance();
+  mgr->add_child(root);
+  double indexed = time_lookups(root, controls, lookups);
+  mgr->remove_child(root);
+  delete root;
+
+  printf("bench: find_child, %d controls, %d lookups\n", controls, lookups);
+  printf("  depth-first: %10.3f ms, %8.3f us per lookup\n", dfs, dfs * 1000.0 / lookups);
+  printf("  indexed:     %10.3f ms, %8.3f us per lookup\n", indexed, indexed * 1000.0 / lookups);
+}
+
+/** SDLEx_RenderFillPolygon **/
+
+static int compare_int(const void *a, const void *b)
+{
+  return (*(const int *) a) - (*(const int *) b);
+}
+
+/* the filler before the active edge table: every edge is tested
+   on each scanline, intersections are sorted with qsort and each
+   span is drawn with its own SDL_RenderDrawLine call */
+static int fill_polygon_scanline(SDL_Renderer * r, const int * vx, const int * vy, int n)
+{
+  std::vector<int> ints(n);
+  int miny = vy[0], maxy = vy[0];
+  for(int i = 1; i < n; ++i) {
+    if (vy[i] < miny) miny = vy[i];
+    else if (vy[i] > maxy) maxy = vy[i];
+  }
+
+  int result = 0;
+  for(int y = miny; y <= maxy; ++y) {
+    int count = 0;
+    for(int i = 0; i < n; ++i) {
+      int ind1 = i == 0 ? n - 1 : i - 1;
+      int ind2 = i;
+      int x1, y1, x2, y2;
+      if (vy[ind1] < vy[ind2]) {
+        x1 = vx[ind1]; y1 = vy[ind1];
+        x2 = vx[ind2]; y2 = vy[ind2];
+      }
+      else if (vy[ind1] > vy[ind2]) {
+        x1 = vx[ind2]; y1 = vy[ind2];
+        x2 = vx[ind1]; y2 = vy[ind1];
+      }
+      else {
+        continue;
+      }
+      if ((y >= y1 && y < y2) || (y == maxy && y > y1 && y <= y2))
+        ints[count++] = ((65536 * (y - y1)) / (y2 - y1)) * (x2 - x1) + (65536 * x1);
+    }
+    qsort(&ints[0], count, sizeof(int), compare_int);
+    for(int i = 0; i + 1 < count; i += 2) {
+      int xa = ints[i] + 1;
+      xa = (xa >> 16) + ((xa & 32768) >> 15);
+      int xb = ints[i + 1] - 1;
+      xb = (xb >> 16) + ((xb & 32768) >> 15);
+      result |= SDL_RenderDrawLine(r, xa, y, xb, y);
+    }
+  }
+  return result;
+}
+
+typedef int (*fill_polygon_fn)(SDL_Renderer *, const int *, const int *, int);
+
+static double time_fill(SDL_Renderer * r, fill_polygon_fn fill,
+                        const int * vx, const int * vy, int n, int runs)
+{
+  Uint64 start = SDL_GetPerformanceCounter();
+  for(int i = 0; i < runs; ++i)
+    fill(r, vx, vy, n);
+#if SDL_VERSION_ATLEAST(2, 0, 10)
+  // include submission of the commands queued by the renderer
+  SDL_RenderFlush(r);
+#endif
+  return elapsed_ms(start);
+}
+
+void bench_fill_polygon(SDL_Renderer * r, int vertices, int runs)
+{
+  // star with spikes reaching the outer radius, all scanlines
+  // cross many edges as in a detailed outline
+  rect display = GM_GetDisplayRect();
+  int cx = display.w / 2, cy = display.h / 2;
+  int outer = min(display.w, display.h) / 2 - 10;
+  int inner = outer / 2;
+  std::vector<int> vx(vertices), vy(vertices);
+  for(int i = 0; i < vertices; ++i) {
+    double angle = 2.0 * M_PI * i / vertices;
+    int rad = (i % 2) ? inner : outer;
+    vx[i] = cx + (int)(rad * cos(angle));
+    vy[i] = cy + (int)(rad * sin(angle));
+  }
+
+  color(0, 0, 100, 255).apply(r);
+  SDL_RenderClear(r);
+  color::green().apply(r);
+  // warm up the driver before measuring
+  SDLEx_RenderFillPolygon(r, &vx[0], &vy[0], vertices);
+  fill_polygon_scanline(r, &vx[0], &vy[0], vertices);
+
+  double scanline = time_fill(r, fill_polygon_scanline, &vx[0], &vy[0], vertices, runs);
+  double aet = time_fill(r, SDLEx_RenderFillPolygon, &vx[0], &vy[0], vertices, runs);
+  SDL_RenderPresent(r);
+
+  printf("bench: SDLEx_RenderFillPolygon, %d vertices, %d runs\n", vertices, runs);
+  printf("  scanline:          %10.3f ms, %8.3f ms per polygon\n", scanline, scanline / runs);
+  printf("  active edge table: %10.3f ms, %8.3f ms per polygon\n", aet, aet / runs);
+}
@@ -0,0 +1,18 @@
+#ifndef _GMDEMO_BENCH_H_
+#define _GMDEMO_BENCH_H_
+
+#include <SDL.h>
+
+/* Benchmarks of the library run by "demo <config> bench",
+   results are printed to stdout */
+
+/* find_child in a tree of controls attached to the manager,
+   where the identifier index is used, and detached from it,
+   where the tree is searched depth-first */
+void bench_find_child(int controls, int lookups);
+
+/* SDLEx_RenderFillPolygon with the active edge table against the
+   scanline filler it replaced, on a star with the given vertices */
+void bench_fill_polygon(SDL_Renderer * r, int vertices, int runs);
+
+#endif //_GMDEMO_BENCH_H_
@@ -7,6 +7,8 @@
 #include "button.h"
 #include "text.h"
 
+#include "bench.h"
+
 class demo_screen : public screen {
 private:
   ui::panel * _panel_with_buttons;
@@ -112,8 +114,9 @@ public:
 
 int main(int argc, char* argv[]) 
 {
-  if (argc != 2) {
-    fprintf(stderr, "demo: no config specified.\nUsage: \"%s path/to/config.json\"\n",
+  bool bench = (argc == 3 && strcmp(argv[2], "bench") == 0);
+  if (argc != 2 && !bench) {
+    fprintf(stderr, "demo: no config specified.\nUsage: \"%s path/to/config.json [bench]\"\n",
       argv[0]);
     return 1;
   }
@@ -124,6 +127,14 @@ int main(int argc, char* argv[])
     return rc;
   }
 
+  // run benchmarks instead of the demo
+  if (bench) {
+    bench_find_child(10000, 1000);
+    bench_fill_polygon(GM_GetRenderer(), 1000, 100);
+    GM_Quit();
+    return rc;
+  }
+
   // setup demo screen
   auto demo = new demo_screen();
   screen::set_current(demo);
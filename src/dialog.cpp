@@ -9,28 +9,27 @@ namespace ui {
 static message * g_message = NULL;
 static std::mutex g_message_mx;
 
-message::message(const std::string & text, const ttf_font * f, const color & c, uint32_t timeout_ms):
+message::message(const std::string & text, const base_font * f, const color & c, uint32_t timeout_ms):
   control(f->get_text_rect(text)),
-  _timeout_ms(timeout_ms)
+  _timeout_ms(timeout_ms),
+  _font(f)
 {
   reset(text, f, c, timeout_ms);
 }
 
-void message::reset(const std::string & text, const ttf_font * f, const color & c, uint32_t timeout_ms)
+void message::reset(const std::string & text, const base_font * f, const color & c, uint32_t timeout_ms)
 {
   _timer.stop();
   set_visible(false);
   _text = text;
-  SDL_Surface *s = f->print_solid(_text, c);
-  _tx.set_surface(s);
-  SDL_FreeSurface(s);
+  _font = f;
+  _color = c;
   rect display = GM_GetDisplayRect();
+  rect text_rect = f->get_text_rect(_text);
 
-  _pos.w = _tx.width();
-  _pos.h = _tx.height();
   // middle of the screen with Y offset
-  _pos.x = (display.w - _pos.w) / 2;
-  _pos.y = 25 + _pos.h;
+  set_pos(rect((display.w - text_rect.w) / 2, 25 + text_rect.h,
+               text_rect.w, text_rect.h));
   show();
 }
 
@@ -53,7 +52,8 @@ void message::update()
   }
 
   uint8_t a = 255 - uint32_to_uint8(depleted);
-  _tx.set_alpha(a);
+  _color.a = a;
+  invalidate();
   g_message_mx.unlock();
 }
 
@@ -71,7 +71,7 @@ void message::alert(const std::string & text, uint32_t timeout_ms)
     timeout_ms);
 }
 
-void message::alert_ex(const std::string & text, const ttf_font * f, const color & c, uint32_t timeout_ms)
+void message::alert_ex(const std::string & text, const base_font * f, const color & c, uint32_t timeout_ms)
 {
   g_message_mx.lock();
   if (g_message == NULL)
@@ -89,7 +89,7 @@ message::~message()
 void message::render(SDL_Renderer * r, const rect & dst)
 {
   g_message_mx.lock();
-  _tx.render(r, dst);
+  _font->render_text(r, _text, dst.topleft(), _color);
   g_message_mx.unlock();
 }
 
@@ -190,7 +190,9 @@ void load_file_dialog::on_file_clicked(ui::control * target)
 
 void load_file_dialog::refresh()
 {
-  main()->clear_children();
+  box * list = main();
+  list->begin_update();
+  list->clear_children();
   paths_list found;
   find_files(found, _ext);
 
@@ -203,8 +205,9 @@ void load_file_dialog::refresh()
     btn->set_text(it->filename().string());
     btn->set_user_data(it->string());
     btn->mouse_up += boost::bind(&load_file_dialog::on_file_clicked, this, _1);
-    main()->add_child(btn);
+    list->add_child(btn);
   }
+  list->end_update();
 }
 
 } // namespace ui
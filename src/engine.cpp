@@ -1,9 +1,14 @@
 #include <boost/filesystem.hpp>
+#include <math.h>
 
 #include "engine.h"
 #include "util.h"
 #include "texture.h"
 #include "sprite.h"
+#include "animation.h"
+#include "glyph_atlas.h"
+#include "sdf_font.h"
+#include "font_registry.h"
 #include "manager.h"
 #include "pyscript.h"
 
@@ -16,7 +21,6 @@ static uint32_t g_counted_frames = 0;
 static uint32_t g_screen_ticks_per_frame = 0;
 
 static float g_avg_fps = 0.0f;
-static texture g_fps;
 static color g_fps_color;
 
 /* Screens */
@@ -26,6 +30,20 @@ static screen * g_screen_next = nullptr;
 static bool g_destroy_on_change = false;
 static bool g_quit = false;
 
+/* Damaged regions of the persistent frame */
+static sdl_mutex g_damage_lock;
+static bool g_partial_redraw = false;
+static SDL_Texture * g_frame = nullptr;
+static std::vector<rect> g_damage;
+static std::vector<rect> g_frame_damage;
+static bool g_damage_all = true;
+static bool g_frame_skipped = false;
+static std::string g_fps_text;
+static rect g_fps_rect;
+
+// more regions are merged into their bounds
+static const size_t max_damage_rects = 8;
+
 SDL_Window* GM_GetWindow() {
     if (g_window == nullptr) {
         SDL_Log("%s: not initialized", __METHOD_NAME__);
@@ -143,6 +161,12 @@ int GM_Init(const std::string & cfg_path, const std::string & name) {
       g_fps_color = color( 0, 255, 0, 255 );
     }
 
+    // damaged regions redraw
+    if (cfg.find("partial_redraw") != cfg.end() &&
+        cfg["partial_redraw"].get<bool>()) {
+      GM_SetPartialRedraw(true);
+    }
+
     return 0;
 }
 
@@ -159,6 +183,9 @@ float GM_CurrentFPS()
 void GM_Quit() 
 {
   python::shutdown();
+  GM_SetPartialRedraw(false);
+  font_registry::instance()->release();
+  SDLEx_ClearCoverageCache();
   SDL_Quit();
 }
 
@@ -195,8 +222,12 @@ void GM_UpdateFrame()
     if (g_screen_current != nullptr && g_destroy_on_change)
       delete g_screen_current;
     g_screen_current = g_screen_next;
+    GM_DamageAll();
   }
     
+  // advance running animations before screens see them
+  anim_scheduler::instance()->update(SDL_GetTicks());
+
   // update global & current screens
   if (g_screen_current != nullptr) {
     g_screen_current->update();  
@@ -210,10 +241,161 @@ void GM_UpdateFrame()
       break;
     }
 
+    // frame texture contents are lost or out of sync with the window
+    if (ev.type == SDL_RENDER_DEVICE_RESET) {
+      mutex_lock damage_guard(g_damage_lock);
+      if (g_frame != nullptr) {
+        SDL_DestroyTexture(g_frame);
+        g_frame = nullptr;
+      }
+    }
+    if (ev.type == SDL_RENDER_TARGETS_RESET || ev.type == SDL_WINDOWEVENT)
+      GM_DamageAll();
+
     g_screen_current->on_event(&ev);
   }
 }
 
+void GM_SetPartialRedraw(bool enabled)
+{
+  mutex_lock guard(g_damage_lock);
+  g_partial_redraw = enabled;
+  g_damage.clear();
+  g_damage_all = true;
+  if (!enabled && g_frame != nullptr) {
+    SDL_DestroyTexture(g_frame);
+    g_frame = nullptr;
+  }
+}
+
+bool GM_GetPartialRedraw()
+{
+  return g_partial_redraw;
+}
+
+void GM_AddDamage(const SDL_Rect & r)
+{
+  if (!g_partial_redraw || r.w <= 0 || r.h <= 0)
+    return;
+  mutex_lock guard(g_damage_lock);
+  if (g_damage_all)
+    return;
+
+  // merge with overlapped regions, the union may overlap others
+  rect d = r;
+  size_t i = 0;
+  while (i < g_damage.size()) {
+    if (SDL_HasIntersection(&d, &g_damage[i])) {
+      SDL_UnionRect(&d, &g_damage[i], &d);
+      g_damage.erase(g_damage.begin() + i);
+      i = 0;
+    }
+    else {
+      ++i;
+    }
+  }
+  if (g_damage.size() >= max_damage_rects) {
+    for(i = 0; i < g_damage.size(); ++i)
+      SDL_UnionRect(&d, &g_damage[i], &d);
+    g_damage.clear();
+  }
+  g_damage.push_back(d);
+}
+
+void GM_DamageAll()
+{
+  mutex_lock guard(g_damage_lock);
+  g_damage.clear();
+  g_damage_all = true;
+}
+
+/* fps counter text, damaged when it changes in the partial redraw */
+static void update_fps_text()
+{
+  std::string text = std::string("fps: ") +
+    std::to_string(float_to_sint32(GM_CurrentFPS()));
+  if (text == g_fps_text)
+    return;
+  g_fps_text = text;
+  GM_AddDamage(g_fps_rect);
+  g_fps_rect = ui::manager::instance()->get_font("fps_counter")->get_text_rect(text);
+  g_fps_rect.x = 5;
+  g_fps_rect.y = 5;
+  GM_AddDamage(g_fps_rect);
+}
+
+static void render_fps_text(SDL_Renderer * r)
+{
+  ui::manager::instance()->get_font("fps_counter")->render_text(r,
+    g_fps_text,
+    point(5, 5),
+    ui::manager::instance()->get_idle_color("fps_counter"));
+}
+
+/* take damage of the frame, false if there is nothing to redraw */
+static bool take_damage(SDL_Renderer * r)
+{
+  int w = 0, h = 0;
+  SDL_GetRendererOutputSize(r, &w, &h);
+
+  mutex_lock guard(g_damage_lock);
+  if (g_frame != nullptr) {
+    int fw = 0, fh = 0;
+    SDL_QueryTexture(g_frame, NULL, NULL, &fw, &fh);
+    if (fw != w || fh != h) {
+      SDL_DestroyTexture(g_frame);
+      g_frame = nullptr;
+    }
+  }
+  if (g_frame == nullptr) {
+    g_frame = SDL_CreateTexture(r, SDL_PIXELFORMAT_ARGB8888,
+      SDL_TEXTUREACCESS_TARGET, w, h);
+    if (g_frame == nullptr) {
+      SDL_Log("%s - failed to create frame texture %dx%d: %s",
+        __METHOD_NAME__, w, h, SDL_GetError());
+      throw sdl_exception();
+    }
+    g_damage_all = true;
+  }
+
+  // damage reported while rendering goes to the next frame
+  g_frame_damage.clear();
+  if (g_damage_all)
+    g_frame_damage.push_back(rect(0, 0, w, h));
+  else
+    g_frame_damage.swap(g_damage);
+  g_damage_all = false;
+  return !g_frame_damage.empty();
+}
+
+/* redraw damaged regions of the frame texture under clip */
+static void render_damaged(SDL_Renderer * r)
+{
+  if (g_fps_timer)
+    update_fps_text();
+
+  if (!take_damage(r)) {
+    g_frame_skipped = true;
+    return;
+  }
+
+  SDL_SetRenderTarget(r, g_frame);
+  std::vector<rect>::iterator it = g_frame_damage.begin();
+  for(; it != g_frame_damage.end(); ++it) {
+    SDL_RenderSetClipRect(r, &(*it));
+    // clear ignores the clip area
+    color::white().apply(r);
+    SDL_RenderFillRect(r, &(*it));
+    g_screen_current->render(r);
+    if (g_fps_timer)
+      render_fps_text(r);
+  }
+  SDL_RenderSetClipRect(r, NULL);
+
+  SDL_SetRenderTarget(r, NULL);
+  SDL_RenderCopy(r, g_frame, NULL, NULL);
+}
+
 void GM_RenderFrame()
 {
   mutex_lock guard(g_screen_lock);
@@ -226,21 +408,22 @@ void GM_RenderFrame()
   }
   SDL_Renderer * r = GM_GetRenderer();
 
-  // reset renderer and paint white
-  SDL_SetRenderTarget(r, NULL);
-  color::white().apply(r);
-  SDL_RenderClear(r);
+  if (g_partial_redraw) {
+    render_damaged(r);
+  }
+  else {
+    // reset renderer and paint white
+    SDL_SetRenderTarget(r, NULL);
+    color::white().apply(r);
+    SDL_RenderClear(r);
+
+    g_screen_current->render(r);
 
-  g_screen_current->render(r);
-  
-  // render avg fps
-  if (g_fps_timer) {
-    SDL_Surface *s = ui::manager::instance()->get_font("fps_counter")->print_solid(
-      std::string("fps: ") + std::to_string(float_to_sint32(GM_CurrentFPS())),
-      ui::manager::instance()->get_idle_color("fps_counter"));
-    g_fps.set_surface(s);
-    SDL_FreeSurface(s);
-    g_fps.render(GM_GetRenderer(), point(5, 5));
+    // render avg fps
+    if (g_fps_timer) {
+      update_fps_text();
+      render_fps_text(r);
+    }
   }
 
   //re-start frame timer
@@ -249,8 +432,10 @@ void GM_RenderFrame()
 
 void GM_EndFrame()
 {
-  //swap opengl buffers
-  SDL_RenderPresent(g_renderer);
+  //swap opengl buffers, unless nothing was drawn
+  if (!g_frame_skipped)
+    SDL_RenderPresent(g_renderer);
+  g_frame_skipped = false;
   //update counted frames and delay frame end
   ++g_counted_frames;
   if (g_screen_ticks_per_frame > 0) {
@@ -399,6 +584,21 @@ TTF_Font* GM_LoadFont(const std::string& file_path, int ptsize)
   return f;
 }
 
+TTF_Font* GM_LoadFontMem(const void * data, size_t size, int ptsize)
+{
+  SDL_RWops * rw = SDL_RWFromConstMem(data, (int)size);
+  if (rw == NULL)
+    throw sdl_exception();
+  // rw is closed by the font
+  TTF_Font* f = TTF_OpenFontRW(rw, 1, ptsize);
+  if (!f) {
+    SDL_Log("%s: failed to load font from memory",
+      __METHOD_NAME__);
+    throw sdl_exception();
+  }
+  return f;
+}
+
 /* Timer implementation */
 
 timer::timer()
@@ -644,29 +844,213 @@ rect rect::center(const uint32_t for_w, const uint32_t for_h) const
 SDL_Surface * ttf_font::print_solid(const std::string & text,
                           const color & clr) const
 {
+  if (_f == nullptr)
+    throw std::runtime_error("Font has no TTF face to print with");
   return TTF_RenderText_Solid(_f, text.c_str(), clr);
 }
 
 SDL_Surface * ttf_font::print_blended(const std::string & text,
                             const color & clr) const
 {
+  if (_f == nullptr)
+    throw std::runtime_error("Font has no TTF face to print with");
   return TTF_RenderText_Blended(_f, text.c_str(), clr);
 }
 
-rect ttf_font::get_text_rect(const std::string& text) const
+rect base_font::get_text_rect(const std::string& text) const
 {
-  rect r(0, 0, 0, 0);
-  TTF_SizeText(_f, text.c_str(), &r.w, &r.h);
+  rect r(0, 0, 0, _height);
+  uint8_t prev = 0;
+  for(size_t i = 0; i < text.length(); ++i) {
+    uint8_t ch = (uint8_t)text[i];
+    r.w += kerning(prev, ch) + _advance[ch];
+    prev = ch;
+  }
   return r;
 }
 
+int base_font::kerning(uint8_t prev, uint8_t ch) const
+{
+  if (!_kerning || prev == 0)
+    return 0;
+  if (_kerning_pairs.empty())
+    _kerning_pairs.resize(256 * 256, INT16_MIN);
+  int16_t & k = _kerning_pairs[prev * 256 + ch];
+  if (k == INT16_MIN)
+    k = (int16_t)load_kerning(prev, ch);
+  return k;
+}
+
+int ttf_font::load_kerning(uint8_t prev, uint8_t ch) const
+{
+  if (_sdf != nullptr)
+    return (int)floorf(_sdf->kerning(prev, ch) * sdf_scale() + 0.5f);
+#if SDL_TTF_VERSION_ATLEAST(2, 0, 14)
+  return TTF_GetFontKerningSizeGlyphs(_f, prev, ch);
+#else
+  return 0;
+#endif
+}
+
+float ttf_font::sdf_scale() const
+{
+  return (float)_pts / sdf_face::base_size;
+}
+
+void ttf_font::load_metrics()
+{
+  if (_sdf != nullptr) {
+    // scaled from base size of the face
+    float scale = sdf_scale();
+    for(int ch = 0; ch < 256; ++ch)
+      _advance[ch] = (int)floorf(_sdf->get_glyph((uint8_t)ch).advance * scale + 0.5f);
+    _height = (int)floorf(_sdf->height() * scale + 0.5f);
+    _kerning = true;
+    _kerning_pairs.clear();
+    return;
+  }
+  for(int ch = 0; ch < 256; ++ch) {
+    int minx = 0, maxx = 0, miny = 0, maxy = 0, advance = 0;
+    if (TTF_GlyphMetrics(_f, (Uint16)ch, &minx, &maxx, &miny, &maxy, &advance) != 0)
+      advance = 0;
+    _advance[ch] = advance;
+  }
+  _height = TTF_FontHeight(_f);
+  _kerning = TTF_GetFontKerning(_f) != 0;
+  _kerning_pairs.clear();
+}
+
+void text_widths::assign(const base_font * f, const std::string & text)
+{
+  _font = f;
+  _x.assign(text.length() + 1, 0);
+  measure(text, 0, text.length());
+}
+
+void text_widths::measure(const std::string & text, size_t from, size_t to)
+{
+  if (_font == nullptr)
+    return;
+  for(size_t i = from; i < to; ++i) {
+    uint8_t ch = (uint8_t)text[i];
+    uint8_t prev = i > 0 ? (uint8_t)text[i - 1] : 0;
+    _x[i + 1] = _x[i] + _font->kerning(prev, ch) + _font->glyph_advance(ch);
+  }
+}
+
+void text_widths::insert(const std::string & text, size_t pos, size_t count)
+{
+  if (pos >= _x.size())
+    pos = _x.size() - 1;
+  int old_next = pos + 1 < _x.size() ? _x[pos + 1] : 0;
+  bool has_tail = pos + 1 < _x.size();
+  _x.insert(_x.begin() + pos + 1, count, 0);
+
+  // inserted chars and the one after them (its kerning pair changed)
+  size_t last = min(pos + count + 1, text.length());
+  measure(text, pos, last);
+  if (!has_tail)
+    return;
+  int delta = _x[pos + count + 1] - old_next;
+  for(size_t i = pos + count + 2; i < _x.size(); ++i)
+    _x[i] += delta;
+}
+
+void text_widths::erase(const std::string & text, size_t pos, size_t count)
+{
+  if (pos + count >= _x.size())
+    count = _x.size() - 1 - pos;
+  if (count == 0)
+    return;
+  bool has_tail = pos + count + 1 < _x.size();
+  int old_next = has_tail ? _x[pos + count + 1] : 0;
+  _x.erase(_x.begin() + pos + 1, _x.begin() + pos + count + 1);
+  if (!has_tail)
+    return;
+
+  // first char after the gap got a new kerning pair
+  measure(text, pos, pos + 1);
+  int delta = _x[pos + 1] - old_next;
+  for(size_t i = pos + 2; i < _x.size(); ++i)
+    _x[i] += delta;
+}
+
+size_t text_widths::index_at(int x) const
+{
+  std::vector<int>::const_iterator it = std::lower_bound(_x.begin(), _x.end(), x);
+  if (it == _x.end())
+    return _x.size() - 1;
+  size_t idx = it - _x.begin();
+  // pick the closer of two boundaries around x
+  if (idx > 0 && x - _x[idx - 1] < *it - x)
+    return idx - 1;
+  return idx;
+}
+
+ttf_font::~ttf_font()
+{
+  delete _atlas[0];
+  delete _atlas[1];
+  if (_f != nullptr)
+    TTF_CloseFont(_f);
+}
+
+glyph_atlas * ttf_font::get_atlas(bool blended) const
+{
+  glyph_atlas *& atlas = _atlas[blended ? 1 : 0];
+  if (atlas == nullptr)
+    atlas = new glyph_atlas(this, blended);
+  return atlas;
+}
+
+void ttf_font::render_text(SDL_Renderer * r, const std::string & text,
+                           const point & at, const color & clr,
+                           bool blended) const
+{
+  get_atlas(blended)->render(r, text, at, clr);
+}
+
 void ttf_font::load(const std::string & file_path, size_t pts)
 {
+  // glyphs of the previous font are no longer valid
+  delete _atlas[0];
+  delete _atlas[1];
+  _atlas[0] = _atlas[1] = nullptr;
   if (_f != nullptr)
     TTF_CloseFont(_f);
+  _sdf = nullptr;
   _pts = pts;
   _f = GM_LoadFont(media_path(file_path), _pts);
   _fname = file_path;
+  load_metrics();
   SDL_Log("ttf_font - loaded %s, pt size: %zu",
           _fname.c_str(), _pts);
 }
+
+void ttf_font::load(const std::string & name, const void * data, size_t size, size_t pts)
+{
+  delete _atlas[0];
+  delete _atlas[1];
+  _atlas[0] = _atlas[1] = nullptr;
+  if (_f != nullptr)
+    TTF_CloseFont(_f);
+  _sdf = nullptr;
+  _pts = pts;
+  _f = GM_LoadFontMem(data, size, _pts);
+  _fname = name;
+  load_metrics();
+}
+
+void ttf_font::load(const sdf_face * face, size_t pts)
+{
+  delete _atlas[0];
+  delete _atlas[1];
+  _atlas[0] = _atlas[1] = nullptr;
+  if (_f != nullptr)
+    TTF_CloseFont(_f);
+  _f = nullptr;
+  _sdf = face;
+  _pts = pts;
+  _fname = face->filename();
+  load_metrics();
+}
@@ -0,0 +1,161 @@
+#include "font_registry.h"
+#include "sdf_font.h"
+#include "bitmap_font.h"
+#include "util.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace ipc = boost::interprocess;
+
+struct font_registry::mapped_file {
+  int index;
+  std::string name;
+  ipc::file_mapping file;
+  ipc::mapped_region region;
+  // created with the first distance field font of the file
+  sdf_face * sdf;
+
+  mapped_file():index(-1), sdf(NULL) {}
+  ~mapped_file() { delete sdf; }
+};
+
+font_registry * font_registry::instance()
+{
+  // initialized once even if first used from several threads
+  static font_registry * g_registry = new font_registry();
+  return g_registry;
+}
+
+font_registry::font_registry()
+{
+}
+
+font_registry::~font_registry()
+{
+  release();
+}
+
+font_registry::mapped_file * font_registry::get_file(const std::string & font_file)
+{
+  std::map<std::string, int>::iterator it = _file_ids.find(font_file);
+  if (it != _file_ids.end())
+    return _files[it->second];
+
+  std::string path = media_path(font_file);
+  mapped_file * mf = new mapped_file();
+  try {
+    mf->file = ipc::file_mapping(path.c_str(), ipc::read_only);
+    mf->region = ipc::mapped_region(mf->file, ipc::read_only);
+  }
+  catch (const ipc::interprocess_exception & ex) {
+    SDL_Log("%s - failed to map %s: %s",
+      __METHOD_NAME__, path.c_str(), ex.what());
+    delete mf;
+    throw std::runtime_error("Failed to map font file");
+  }
+  mf->index = (int)_files.size();
+  mf->name = font_file;
+  _files.push_back(mf);
+  _file_ids.insert(std::make_pair(font_file, mf->index));
+  return mf;
+}
+
+font_registry::font_id font_registry::intern(const std::string & font_file, size_t pts, bool sdf)
+{
+  mutex_lock guard(_m);
+  mapped_file * mf = get_file(font_file);
+  bool bitmap = path(font_file).extension() == ".fnt";
+  if (bitmap) {
+    // one prebaked size, any requested one maps to it
+    pts = 0;
+    sdf = false;
+  }
+  uint64_t key = ((uint64_t)mf->index << 32) | ((uint64_t)pts << 1) | (sdf ? 1 : 0);
+  std::map<uint64_t, font_id>::iterator it = _ids.find(key);
+  if (it != _ids.end())
+    return it->second;
+
+  base_font * font = NULL;
+  if (bitmap) {
+    font = new bitmap_font(mf->name, (const char *)mf->region.get_address(), mf->region.get_size());
+  }
+  else if (sdf) {
+    if (mf->sdf == NULL)
+      mf->sdf = new sdf_face(mf->name, mf->region.get_address(), mf->region.get_size());
+    font = new ttf_font(mf->sdf, pts);
+  }
+  else {
+    font = new ttf_font(mf->name, mf->region.get_address(), mf->region.get_size(), pts);
+  }
+
+  font_id id = (font_id)_fonts.size();
+  _fonts.push_back(font);
+  _ids.insert(std::make_pair(key, id));
+#ifdef GM_DEBUG
+  SDL_Log("%s - %s, pt size: %zu%s is #%d",
+    __METHOD_NAME__, font_file.c_str(), pts, sdf ? " (sdf)" : "", id);
+#endif
+  return id;
+}
+
+base_font * font_registry::get(font_id id)
+{
+  mutex_lock guard(_m);
+  if (id < 0 || id >= (font_id)_fonts.size()) {
+    SDL_Log("%s - invalid font handle %d", __METHOD_NAME__, id);
+    throw std::runtime_error("Invalid font handle");
+  }
+  return _fonts[id];
+}
+
+void font_registry::preload(const json & theme)
+{
+  if (theme.is_object()) {
+    json::const_iterator it = theme.begin();
+    for(; it != theme.end(); ++it) {
+      const json & font = it.value();
+      if (it.key() == "font" && font.is_array() && font.size() > 1) {
+        bool sdf = font.size() > 2 && font.at(2) == "sdf";
+        intern(font.at(0), font.at(1), sdf);
+      }
+      else {
+        preload(font);
+      }
+    }
+  }
+  else if (theme.is_array()) {
+    json::const_iterator it = theme.begin();
+    for(; it != theme.end(); ++it)
+      preload(*it);
+  }
+}
+
+void font_registry::release()
+{
+  mutex_lock guard(_m);
+  // fonts read from the mappings, close them first
+  std::vector<base_font *>::iterator f = _fonts.begin();
+  for(; f != _fonts.end(); ++f)
+    delete *f;
+  _fonts.clear();
+  _ids.clear();
+
+  std::vector<mapped_file *>::iterator m = _files.begin();
+  for(; m != _files.end(); ++m)
+    delete *m;
+  _files.clear();
+  _file_ids.clear();
+}
+
+size_t font_registry::fonts_count()
+{
+  mutex_lock guard(_m);
+  return _fonts.size();
+}
+
+size_t font_registry::files_count()
+{
+  mutex_lock guard(_m);
+  return _files.size();
+}
@@ -0,0 +1,181 @@
+#include "glyph_atlas.h"
+#include "sdf_font.h"
+
+glyph_atlas::glyph_atlas(const ttf_font * f, bool blended):
+  _font(f),
+  _blended(blended),
+  _shelf_x(0),
+  _shelf_y(0),
+  _shelf_h(0)
+{
+  for(int i = 0; i < 256; ++i) {
+    _glyphs[i].page = -1;
+    _glyphs[i].advance = 0;
+  }
+}
+
+glyph_atlas::~glyph_atlas()
+{
+  std::vector<texture*>::iterator it = _pages.begin();
+  for(; it != _pages.end(); ++it) {
+    delete *it;
+  }
+}
+
+void glyph_atlas::add_page()
+{
+  texture * page = new texture(page_width, page_height, SDL_TEXTUREACCESS_STATIC);
+  // static textures start with undefined pixels
+  std::vector<uint32_t> blank(page_width * page_height, 0);
+  if (SDL_UpdateTexture(page->get_texture(), NULL, &blank[0], page_width * 4) != 0)
+    throw sdl_exception();
+  _pages.push_back(page);
+  _shelf_x = 0;
+  _shelf_y = 0;
+  _shelf_h = 0;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+  _batches.resize(_pages.size());
+#endif
+}
+
+void glyph_atlas::add_glyph(uint8_t ch)
+{
+  glyph & g = _glyphs[ch];
+  g.advance = _font->glyph_advance(ch);
+  g.clip = rect();
+
+  if (_pages.empty())
+    add_page();
+
+  // glyphs are white, color comes from vertices or color mod
+  SDL_Surface * s = NULL;
+  const sdf_face * face = _font->get_sdf_face();
+  if (face != NULL)
+    s = face->render_glyph(ch, _font->sdf_scale(), _blended);
+  else if (_blended)
+    s = TTF_RenderGlyph_Blended(_font->get_font(), ch, color::white());
+  else
+    s = TTF_RenderGlyph_Solid(_font->get_font(), ch, color::white());
+  if (s == NULL) {
+    // nothing to draw, i.e. a space in some fonts
+    g.page = (int)_pages.size() - 1;
+    return;
+  }
+
+  SDL_Surface * rgba = SDL_ConvertSurfaceFormat(s, SDL_PIXELFORMAT_RGBA8888, 0);
+  SDL_FreeSurface(s);
+  if (rgba == NULL)
+    throw sdl_exception();
+
+  if (rgba->w > page_width || rgba->h > page_height) {
+    SDL_Log("%s - glyph %d of %s is too large for atlas: %dx%d",
+      __METHOD_NAME__, ch, _font->tostr().c_str(), rgba->w, rgba->h);
+    SDL_FreeSurface(rgba);
+    throw std::runtime_error("Glyph is too large for atlas page");
+  }
+
+  // next shelf or next page if it does not fit
+  if (_shelf_x + rgba->w > page_width) {
+    _shelf_x = 0;
+    _shelf_y += _shelf_h;
+    _shelf_h = 0;
+  }
+  if (_shelf_y + rgba->h > page_height) {
+    add_page();
+  }
+
+  g.page = (int)_pages.size() - 1;
+  g.clip = rect(_shelf_x, _shelf_y, rgba->w, rgba->h);
+  int rc = SDL_UpdateTexture(_pages[g.page]->get_texture(), &g.clip, rgba->pixels, rgba->pitch);
+  SDL_FreeSurface(rgba);
+  if (rc != 0)
+    throw sdl_exception();
+
+  // keep a pixel between glyphs for linear filtering
+  _shelf_x += g.clip.w + 1;
+  _shelf_h = max(_shelf_h, g.clip.h + 1);
+}
+
+const glyph_atlas::glyph & glyph_atlas::get_glyph(uint8_t ch)
+{
+  if (_glyphs[ch].page < 0)
+    add_glyph(ch);
+  return _glyphs[ch];
+}
+
+void glyph_atlas::render(SDL_Renderer * r, const std::string & text, const point & at, const color & clr)
+{
+  if (text.empty())
+    return;
+
+  // rasterize missing glyphs first, pages may be added
+  for(size_t i = 0; i < text.length(); ++i)
+    get_glyph((uint8_t)text[i]);
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+  for(size_t p = 0; p < _batches.size(); ++p)
+    _batches[p].clear();
+
+  float x = (float)at.x;
+  float y = (float)at.y;
+  uint8_t prev = 0;
+  for(size_t i = 0; i < text.length(); ++i) {
+    uint8_t ch = (uint8_t)text[i];
+    const glyph & g = _glyphs[ch];
+    x += _font->kerning(prev, ch);
+    prev = ch;
+    if (g.clip.w > 0 && g.clip.h > 0) {
+      float u0 = (float)g.clip.x / page_width;
+      float v0 = (float)g.clip.y / page_height;
+      float u1 = (float)(g.clip.x + g.clip.w) / page_width;
+      float v1 = (float)(g.clip.y + g.clip.h) / page_height;
+      SDL_Vertex quad[4];
+      quad[0].position.x = x;             quad[0].position.y = y;
+      quad[1].position.x = x + g.clip.w;  quad[1].position.y = y;
+      quad[2].position.x = x + g.clip.w;  quad[2].position.y = y + g.clip.h;
+      quad[3].position.x = x;             quad[3].position.y = y + g.clip.h;
+      quad[0].tex_coord.x = u0; quad[0].tex_coord.y = v0;
+      quad[1].tex_coord.x = u1; quad[1].tex_coord.y = v0;
+      quad[2].tex_coord.x = u1; quad[2].tex_coord.y = v1;
+      quad[3].tex_coord.x = u0; quad[3].tex_coord.y = v1;
+      quad[0].color = quad[1].color = quad[2].color = quad[3].color = clr;
+      _batches[g.page].insert(_batches[g.page].end(), quad, quad + 4);
+    }
+    x += g.advance;
+  }
+
+  // one draw call per page, indices are shared by all batches
+  for(size_t p = 0; p < _batches.size(); ++p) {
+    std::vector<SDL_Vertex> & batch = _batches[p];
+    if (batch.empty())
+      continue;
+    size_t quads = batch.size() / 4;
+    for(size_t q = _indices.size() / 6; q < quads; ++q) {
+      int v = (int)q * 4;
+      int idx[6] = { v, v + 1, v + 2, v, v + 2, v + 3 };
+      _indices.insert(_indices.end(), idx, idx + 6);
+    }
+    if (SDL_RenderGeometry(r, _pages[p]->get_texture(),
+                           &batch[0], (int)batch.size(),
+                           &_indices[0], (int)quads * 6) != 0)
+      throw sdl_exception();
+  }
+#else
+  std::vector<texture*>::iterator it = _pages.begin();
+  for(; it != _pages.end(); ++it) {
+    (*it)->set_color_mod(clr);
+    (*it)->set_alpha(clr.a);
+  }
+  int x = at.x;
+  uint8_t prev = 0;
+  for(size_t i = 0; i < text.length(); ++i) {
+    uint8_t ch = (uint8_t)text[i];
+    const glyph & g = _glyphs[ch];
+    x += _font->kerning(prev, ch);
+    prev = ch;
+    if (g.clip.w > 0 && g.clip.h > 0)
+      _pages[g.page]->render(r, g.clip, rect(x, at.y, g.clip.w, g.clip.h));
+    x += g.advance;
+  }
+#endif
+}
@@ -13,11 +13,8 @@ label::label(const rect & pos,
   _icon_pos(icon), _icon_gap(gap),
   _icon_tx(nullptr),
   _style(get_type_name()),
-  _font(ui::manager::instance()->get_font(_style)),
-  _font_style(ui::manager::instance()->get_font_style(_style)),
-  _color_idle(ui::manager::instance()->get_idle_color(_style)),
-  _color_highlight(ui::manager::instance()->get_highlight_color(_style)),
-  _color_back(ui::manager::instance()->get_back_color(_style)),
+  _font(nullptr),
+  _font_style(font_style::solid),
   _dirty(true),
   _sticky(false),
   _stuck(false),
@@ -30,6 +27,7 @@ label::label(const rect & pos,
   _alpha(255),
   _alpha_step(0)
 {
+  set_style(_style);
   hovered += boost::bind( &label::on_hovered, this, _1 );
   hover_lost += boost::bind( &label::on_hover_lost, this, _1 );
   focused += boost::bind( &label::on_focused, this, _1 );
@@ -51,7 +49,32 @@ void label::set_text(const std::string& txt)
     return;
   }
   _text = txt;
-  _dirty = true;
+  _widths.assign(_font, _text);
+  mark_dirty();
+  content_resized();
+}
+
+void label::insert_text(size_t pos, const std::string & txt)
+{
+  if (_animating)
+    return;
+  if (pos > _text.length())
+    pos = _text.length();
+  _text.insert(pos, txt);
+  _widths.insert(_text, pos, txt.length());
+  mark_dirty();
+  content_resized();
+}
+
+void label::erase_text(size_t pos, size_t count)
+{
+  if (_animating || pos >= _text.length())
+    return;
+  count = min(count, _text.length() - pos);
+  _text.erase(pos, count);
+  _widths.erase(_text, pos, count);
+  mark_dirty();
+  content_resized();
 }
 
 void label::set_icon(const std::string& icon_file)
@@ -61,7 +84,12 @@ void label::set_icon(const std::string& icon_file)
     return;
   }
   _icon_file = icon_file;
-  _dirty = true;
+  if (_icon_tx != nullptr) {
+    delete _icon_tx;
+    _icon_tx = nullptr;
+  }
+  mark_dirty();
+  content_resized();
 }
 
 void label::set_icon(SDL_Surface* icon)
@@ -75,6 +103,8 @@ void label::set_icon(SDL_Surface* icon)
   if (_icon_tx != nullptr)
     delete _icon_tx;
   _icon_tx = new texture(NULL, icon);
+  mark_dirty();
+  content_resized();
 }
 
 void label::set_icon(texture* icon)
@@ -88,54 +118,59 @@ void label::set_icon(texture* icon)
   if (_icon_tx != nullptr)
     delete _icon_tx;
   _icon_tx = icon;
+  mark_dirty();
+  content_resized();
 }
 
 void label::set_icon_gap(int gap)
 {
   _icon_gap = gap;
-  _dirty = true;
+  mark_dirty();
+  content_resized();
 }
 
 void label::set_style(const std::string &st)
 {
   _style = st;
-  _font = ui::manager::instance()->get_font(_style);
-  _font_style = ui::manager::instance()->get_font_style(_style);
-  _color_idle = ui::manager::instance()->get_idle_color(_style);
-  _color_highlight = ui::manager::instance()->get_highlight_color(_style);
-  _color_back = ui::manager::instance()->get_back_color(_style);
+  const theme_style & style = ui::manager::instance()->get_style(_style);
+  _font = style.get_font();
+  _font_style = style.get_font_style();
+  _color_idle = style.get_idle_color();
+  _color_highlight = style.get_highlight_color();
+  _color_back = style.get_back_color();
+  content_resized();
 }
 
 void label::on_hovered(control * target)
 {
   _hovered = true;
-  _dirty = true;
+  mark_dirty();
 }
 
 void label::on_hover_lost(control * target)
 {
   _hovered = false;
   _pressed = false;
-  _dirty = true;
+  mark_dirty();
 }
 
 void label::on_focused(control * target)
 {
   _focused = true;
-  _dirty = true;
+  mark_dirty();
 }
 
 void label::on_focus_lost(control * target)
 {
   _focused = false;
   _pressed = false;
-  _dirty = true;
+  mark_dirty();
 }
 
 void label::on_mouse_up(control * target)
 {
   _pressed = false;
-  _dirty = true;
+  mark_dirty();
   if (_sticky)
     _stuck = !_stuck;
 }
@@ -143,13 +178,15 @@ void label::on_mouse_up(control * target)
 void label::on_mouse_down(control * target)
 {
   _pressed = true;
-  _dirty = true;
+  mark_dirty();
 }
 
 void label::load(const json & d)
 {
-  if (d.find("text") != d.end())
+  if (d.find("text") != d.end()) {
     _text = d["text"];
+    _widths.assign(_font, _text);
+  }
   if (d.find("icon") != d.end())
     _icon_file = d["icon"];
 
@@ -245,6 +282,7 @@ void label::update()
 
     if (_alpha < 0 ) _alpha = 0;
     if (_alpha > 255) _alpha = 255;
+    invalidate();
     
     SDL_Log("label::update - fade in %d/%d", _alpha, _alpha_step);
   }
@@ -279,21 +317,40 @@ void label::draw(SDL_Renderer * r, const rect & dst)
   if (_icon_tx != nullptr)
     _icon_tx->render(r, dst.topleft() + _icon_offset);
 
-  _text_tx.set_alpha(int32_to_uint8(_alpha));
-  _text_tx.render(r, dst.topleft() + _text_offset);
+  if (_text.length() > 0) {
+    color clr = _text_color;
+    clr.a = int32_to_uint8(clr.a * _alpha / 255);
+    _font->render_text(r, _text, dst.topleft() + _text_offset, clr,
+                       _font_style == font_style::blended);
+  }
 
   control::draw(r, dst);
 }
 
-void label::paint_text(texture & tx, const std::string & text, const ttf_font * fnt, const color & clr)
+void label::content_resized()
+{
+  // only labels sized by their text affect layouts
+  if (auto_sized())
+    invalidate_measure();
+}
+
+point label::measure_content()
 {
-  SDL_Surface *s;
-  if (_font_style == font_style::blended)
-    s = fnt->print_blended(text.length() > 0 ? text : " ", clr);
-  else
-    s = fnt->print_solid(text.length() > 0 ? text : " ", clr);
-  tx.set_surface(s);
-  SDL_FreeSurface(s);
+  if (_font == nullptr)
+    return point(_pad.left + _pad.right, _pad.top + _pad.bottom);
+  if (_icon_file.size() > 0 && _icon_tx == nullptr) {
+    _icon_tx = new texture();
+    _icon_tx->load(_icon_file);
+  }
+  if (_widths.font() != _font || _widths.length() != _text.length())
+    _widths.assign(_font, _text);
+  int w = _widths.width();
+  int h = _font->line_height();
+  if (_icon_tx != nullptr) {
+    w += _icon_tx->width() + (_text.empty() ? 0 : _icon_gap);
+    h = max(h, _icon_tx->height());
+  }
+  return point(_pad.left + w + _pad.right, _pad.top + h + _pad.bottom);
 }
 
 void label::paint(SDL_Renderer * r)
@@ -308,7 +365,11 @@ void label::paint(SDL_Renderer * r)
   else if (is_hovered() && _highlight_on_hover) {
     clr = _color_highlight;
   }
-  paint_text(_text_tx, _text, _font, clr);
+  // font or text could be replaced directly
+  if (_widths.font() != _font || _widths.length() != _text.length())
+    _widths.assign(_font, _text);
+  _text_color = clr;
+  _text_rect = rect(0, 0, _widths.width(), _font->line_height());
 
   // load icon as resource only if given
   if (_icon_file.size() > 0 && _icon_tx == nullptr) {
@@ -327,7 +388,7 @@ void label::paint(SDL_Renderer * r)
   int total_avail_h = _pos.h - (_pad.top + _pad.bottom);
   int icon_w = (_icon_tx != nullptr ? _icon_tx->width() : 0);
   int icon_h = (_icon_tx != nullptr ? _icon_tx->height() : 0);
-  int total_label_w = icon_w + _text_tx.width();
+  int total_label_w = icon_w + _text_rect.w;
 
   // horizontal alignment
   if (_ha == h_align::center) {
@@ -339,7 +400,7 @@ void label::paint(SDL_Renderer * r)
     if (_icon_pos == icon_pos::icon_right) {
       // text first
       _text_offset.x = _pad.left + (total_avail_w - total_label_w) / 2;
-      _icon_offset.x = _text_offset.x + _text_tx.width() + _icon_gap;
+      _icon_offset.x = _text_offset.x + _text_rect.w + _icon_gap;
     }
   }
   if (_ha == h_align::left) {
@@ -351,26 +412,26 @@ void label::paint(SDL_Renderer * r)
     if (_icon_pos == icon_pos::icon_right) {
       // text first
       _text_offset.x = _pad.left;
-      _icon_offset.x = _text_offset.x + _text_tx.width() + _icon_gap;
+      _icon_offset.x = _text_offset.x + _text_rect.w + _icon_gap;
     }
   }
   if (_ha == h_align::right) {
     if (_icon_pos == icon_pos::icon_left) {
       // icon first
-      _text_offset.x = _pos.w - _text_tx.width() - _pad.right;
+      _text_offset.x = _pos.w - _text_rect.w - _pad.right;
       _icon_offset.x = _text_offset.x - icon_w - _icon_gap;
     }
     if (_icon_pos == icon_pos::icon_right) {
       // text first
       _icon_offset.x = _pos.w - icon_w - _pad.right;
-      _text_offset.x = _icon_offset.x - _text_tx.width() - _icon_gap;
+      _text_offset.x = _icon_offset.x - _text_rect.w - _icon_gap;
     }
   }
 
   // vertical alignment
   if (_va == v_align::middle) {
     _icon_offset.y = _pad.top + (total_avail_h - icon_h) / 2;
-    _text_offset.y = _pad.top + (total_avail_h - _text_tx.height()) / 2;
+    _text_offset.y = _pad.top + (total_avail_h - _text_rect.h) / 2;
   }
   if (_va == v_align::top) {
     _icon_offset.y = _pad.top;
@@ -378,7 +439,7 @@ void label::paint(SDL_Renderer * r)
   }
   if (_va == v_align::bottom) {
     _icon_offset.y = _pos.h - icon_h - _pad.bottom;
-    _text_offset.y = _pos.h - _text_tx.height() - _pad.bottom;
+    _text_offset.y = _pos.h - _text_rect.h - _pad.bottom;
   }
 }
 
@@ -0,0 +1,252 @@
+#include "listview.h"
+#include "label.h"
+
+namespace ui {
+
+/** List Source **/
+
+control * list_source::create_row(const rect & pos)
+{
+  return new label(pos, icon_pos::icon_left, h_align::left, v_align::middle);
+}
+
+/** List View **/
+
+list_view::list_view(const rect & pos, int row_height, size_t overscan):
+  control(pos),
+  _source(nullptr),
+  _style(get_type_name()),
+  _row_h(max(row_height, 1)),
+  _overscan(overscan),
+  _scroll(0),
+  _selected(no_item)
+{
+  set_style(_style);
+  mouse_wheel += boost::bind(&list_view::on_wheel, this, _1);
+}
+
+list_view::~list_view()
+{
+}
+
+void list_view::set_style(const std::string & st)
+{
+  _style = st;
+  _color_back = ui::manager::instance()->get_style(_style).get_back_color();
+  invalidate();
+}
+
+void list_view::set_source(list_source * src)
+{
+  _source = src;
+  _scroll = 0;
+  _selected = no_item;
+  create_rows();
+}
+
+void list_view::set_row_height(int h)
+{
+  _row_h = max(h, 1);
+  create_rows();
+}
+
+void list_view::set_overscan(size_t n)
+{
+  _overscan = n;
+  create_rows();
+}
+
+size_t list_view::max_scroll() const
+{
+  size_t n = _source != nullptr ? _source->count() : 0;
+  size_t total = n * _row_h;
+  size_t view = (size_t)max(_pos.h, 0);
+  return total > view ? total - view : 0;
+}
+
+size_t list_view::rows_needed() const
+{
+  // a partially visible row at both ends and the overscan
+  size_t visible = (size_t)(max(_pos.h, 0) + _row_h - 1) / _row_h + 1;
+  return visible + 2 * _overscan;
+}
+
+void list_view::release_rows()
+{
+  std::vector<control*>::iterator it = _rows.begin();
+  for(; it != _rows.end(); ++it) {
+    remove_child(*it);
+    ui::destroy(*it);
+  }
+  _rows.clear();
+  _row_items.clear();
+}
+
+void list_view::create_rows()
+{
+  release_rows();
+  if (_source == nullptr)
+    return;
+
+  size_t count = rows_needed();
+  _rows.reserve(count);
+  for(size_t i = 0; i < count; ++i) {
+    control * row = _source->create_row(rect(0, 0, _pos.w, _row_h));
+    row->mouse_up += boost::bind(&list_view::on_row_click, this, _1);
+    row->mouse_wheel += boost::bind(&list_view::on_wheel, this, _1);
+    row->set_visible(false);
+    add_child(row);
+    _rows.push_back(row);
+  }
+  _row_items.assign(count, no_item);
+  update_rows();
+}
+
+void list_view::update_rows()
+{
+  if (_rows.empty())
+    return;
+
+  size_t n = _source->count();
+  size_t slots = _rows.size();
+  _scroll = min(_scroll, max_scroll());
+  size_t first = _scroll / _row_h;
+  first = first > _overscan ? first - _overscan : 0;
+
+  // every slot gets one item of the range, rows keep
+  // items which are still in it and only the rest is bound
+  for(size_t item = first; item < first + slots; ++item) {
+    size_t slot = item % slots;
+    control * row = _rows[slot];
+    if (item >= n) {
+      _row_items[slot] = no_item;
+      row->set_visible(false);
+      continue;
+    }
+    if (_row_items[slot] != item)
+      bind_item(item);
+    int y = (int)((long long)item * _row_h - (long long)_scroll);
+    row->arrange(rect(0, y, _pos.w, _row_h));
+    row->set_visible(true);
+  }
+}
+
+void list_view::bind_item(size_t item)
+{
+  size_t slot = item % _rows.size();
+  _row_items[slot] = item;
+  _source->bind(this, _rows[slot], item);
+}
+
+void list_view::refresh()
+{
+  _row_items.assign(_rows.size(), no_item);
+  if (_source != nullptr && _selected != no_item && _selected >= _source->count())
+    _selected = no_item;
+  update_rows();
+  invalidate();
+}
+
+size_t list_view::get_row_item(const control * row) const
+{
+  for(size_t i = 0; i < _rows.size(); ++i) {
+    if (_rows[i] == row)
+      return _row_items[i];
+  }
+  return no_item;
+}
+
+void list_view::set_selected(size_t item)
+{
+  if (item == _selected)
+    return;
+  size_t prev = _selected;
+  _selected = item;
+  // bound rows show the selection change
+  if (!_rows.empty()) {
+    if (prev != no_item && _row_items[prev % _rows.size()] == prev)
+      bind_item(prev);
+    if (item != no_item && _row_items[item % _rows.size()] == item)
+      bind_item(item);
+  }
+  selection_change(this);
+}
+
+void list_view::scroll_to(size_t px)
+{
+  _scroll = min(px, max_scroll());
+  update_rows();
+  invalidate();
+}
+
+void list_view::scroll_by(int px)
+{
+  if (px < 0 && (size_t)-px > _scroll)
+    scroll_to(0);
+  else
+    scroll_to(_scroll + px);
+}
+
+void list_view::scroll_to_item(size_t item)
+{
+  size_t top = item * _row_h;
+  size_t view = (size_t)max(_pos.h, 0);
+  if (top < _scroll)
+    scroll_to(top);
+  else if (top + _row_h > _scroll + view)
+    scroll_to(top + _row_h - view);
+}
+
+void list_view::on_row_click(control * target)
+{
+  size_t item = get_row_item(target);
+  if (item != no_item)
+    set_selected(item);
+}
+
+void list_view::on_wheel(control * target)
+{
+  const SDL_Event * sdl_ev = ui::manager::current_event();
+  scroll_by(-sdl_ev->wheel.y * _row_h * 3);
+}
+
+void list_view::update()
+{
+  // resized views need another count of rows
+  if (_source != nullptr) {
+    if (_rows.size() != rows_needed())
+      create_rows();
+    else
+      update_rows();
+  }
+  control::update();
+}
+
+void list_view::load(const json & d)
+{
+  if (d.find("color_back") != d.end())
+    _color_back = color::from_json(d["color_back"]);
+
+  if (d.find("row_height") != d.end() && d["row_height"].is_number())
+    _row_h = max(d["row_height"].get<int>(), 1);
+
+  if (d.find("overscan") != d.end() && d["overscan"].is_number())
+    _overscan = d["overscan"].get<size_t>();
+
+  control::load(d);
+  create_rows();
+}
+
+void list_view::draw(SDL_Renderer * r, const rect & dst)
+{
+  if (_color_back.a > 0) {
+    _color_back.apply(r);
+    SDL_RenderFillRect(r, &dst);
+  }
+
+  // rows at the ends are partially visible
+  texture::clip_context clip(r, dst);
+  control::draw(r, dst);
+}
+
+} //namespace ui
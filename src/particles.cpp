@@ -0,0 +1,382 @@
+#include "particles.h"
+#include <math.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define GM_PARTICLES_SSE
+#endif
+
+// do not bother threads for small batches
+static const size_t min_job_size = 4096;
+
+particle_emitter::settings::settings():
+  rate(100.0f),
+  life_min(1.0f),
+  life_max(2.0f),
+  speed_min(50.0f),
+  speed_max(100.0f),
+  angle_min(0.0f),
+  angle_max(360.0f),
+  gravity_x(0.0f),
+  gravity_y(0.0f),
+  size_start(8.0f),
+  size_end(2.0f),
+  color_start(color::white()),
+  color_end(color(255, 255, 255, 0))
+{
+}
+
+particle_emitter::particle_emitter(screen * s, size_t capacity,
+                                   const sprites_sheet * sheet, size_t frame):
+  screen::component(s),
+  _active(true),
+  _threads(1),
+  _sheet(sheet),
+  _capacity(capacity),
+  _count(0),
+  _emit_acc(0.0f),
+  _last_ticks(0),
+  _dt(0.0f),
+  _seed(0x9e3779b9u),
+  _pool_threads(1),
+  _pool_mx(NULL),
+  _pool_wake(NULL),
+  _pool_done(NULL),
+  _pool_frame(0),
+  _pool_pending(0),
+  _pool_quit(false),
+  _x(capacity), _y(capacity),
+  _vx(capacity), _vy(capacity),
+  _age(capacity), _life(capacity)
+{
+  if (_sheet != NULL)
+    _clip = _sheet->get_sprite_cliprect(frame);
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+  // quads index pattern never changes
+  _vertices.resize(capacity * 4);
+  _indices.resize(capacity * 6);
+  for(size_t i = 0; i < capacity; ++i) {
+    int v = (int)i * 4;
+    int * idx = &_indices[i * 6];
+    idx[0] = v; idx[1] = v + 1; idx[2] = v + 2;
+    idx[3] = v; idx[4] = v + 2; idx[5] = v + 3;
+  }
+#endif
+}
+
+particle_emitter::~particle_emitter()
+{
+  stop_workers();
+}
+
+float particle_emitter::random(float from, float to)
+{
+  // xorshift32, rand() is too slow for bursts of thousands
+  _seed ^= _seed << 13;
+  _seed ^= _seed >> 17;
+  _seed ^= _seed << 5;
+  return from + (to - from) * ((_seed >> 8) * (1.0f / 16777216.0f));
+}
+
+void particle_emitter::burst(size_t count)
+{
+  count = min(count, _capacity - _count);
+  const float deg_to_rad = 3.14159265f / 180.0f;
+  for(size_t i = _count; i < _count + count; ++i) {
+    float angle = random(_settings.angle_min, _settings.angle_max) * deg_to_rad;
+    float speed = random(_settings.speed_min, _settings.speed_max);
+    _x[i] = (float)_pos.x;
+    _y[i] = (float)_pos.y;
+    _vx[i] = cosf(angle) * speed;
+    _vy[i] = sinf(angle) * speed;
+    _age[i] = 0.0f;
+    _life[i] = max(random(_settings.life_min, _settings.life_max), 0.001f);
+  }
+  _count += count;
+}
+
+void particle_emitter::simulate(size_t from, size_t to, float dt)
+{
+  float * x = &_x[0];
+  float * y = &_y[0];
+  float * vx = &_vx[0];
+  float * vy = &_vy[0];
+  float * age = &_age[0];
+  float ax = _settings.gravity_x * dt;
+  float ay = _settings.gravity_y * dt;
+
+  size_t i = from;
+#ifdef GM_PARTICLES_SSE
+  __m128 vdt = _mm_set1_ps(dt);
+  __m128 vax = _mm_set1_ps(ax);
+  __m128 vay = _mm_set1_ps(ay);
+  for(; i + 4 <= to; i += 4) {
+    __m128 nvx = _mm_add_ps(_mm_loadu_ps(vx + i), vax);
+    __m128 nvy = _mm_add_ps(_mm_loadu_ps(vy + i), vay);
+    _mm_storeu_ps(vx + i, nvx);
+    _mm_storeu_ps(vy + i, nvy);
+    _mm_storeu_ps(x + i, _mm_add_ps(_mm_loadu_ps(x + i), _mm_mul_ps(nvx, vdt)));
+    _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(nvy, vdt)));
+    _mm_storeu_ps(age + i, _mm_add_ps(_mm_loadu_ps(age + i), vdt));
+  }
+#endif
+  for(; i < to; ++i) {
+    vx[i] += ax;
+    vy[i] += ay;
+    x[i] += vx[i] * dt;
+    y[i] += vy[i] * dt;
+    age[i] += dt;
+  }
+}
+
+int particle_emitter::simulate_worker(void * param)
+{
+  worker * w = (worker *)param;
+  particle_emitter * e = w->emitter;
+  uint32_t seen = 0;
+  SDL_LockMutex(e->_pool_mx);
+  for(;;) {
+    while (!e->_pool_quit && seen == e->_pool_frame)
+      SDL_CondWait(e->_pool_wake, e->_pool_mx);
+    if (e->_pool_quit)
+      break;
+    seen = e->_pool_frame;
+    SDL_UnlockMutex(e->_pool_mx);
+
+    e->simulate(w->from, w->to, e->_dt);
+
+    SDL_LockMutex(e->_pool_mx);
+    if (--e->_pool_pending == 0)
+      SDL_CondSignal(e->_pool_done);
+  }
+  SDL_UnlockMutex(e->_pool_mx);
+  return 0;
+}
+
+void particle_emitter::start_workers(size_t n)
+{
+  _pool_mx = SDL_CreateMutex();
+  _pool_wake = SDL_CreateCond();
+  _pool_done = SDL_CreateCond();
+  _pool_quit = false;
+  // new threads wait for the frame after this one
+  _pool_frame = 0;
+  _pool_pending = 0;
+  if (_pool_mx == NULL || _pool_wake == NULL || _pool_done == NULL) {
+    SDL_Log("%s - failed to create worker pool: %s", __METHOD_NAME__, SDL_GetError());
+    stop_workers();
+    return;
+  }
+
+  // addresses of workers are passed to threads, no resizing after this
+  _workers.resize(n);
+  size_t started = 0;
+  for(size_t i = 0; i < n; ++i) {
+    worker & w = _workers[i];
+    w.emitter = this;
+    w.from = w.to = 0;
+    w.thread = SDL_CreateThread(simulate_worker, "particles", &w);
+    if (w.thread == NULL) {
+      SDL_Log("%s - failed to start worker: %s", __METHOD_NAME__, SDL_GetError());
+      break;
+    }
+    ++started;
+  }
+  // fewer workers only split the work in fewer ranges
+  _workers.resize(started);
+}
+
+void particle_emitter::stop_workers()
+{
+  if (_pool_mx != NULL) {
+    SDL_LockMutex(_pool_mx);
+    _pool_quit = true;
+    SDL_CondBroadcast(_pool_wake);
+    SDL_UnlockMutex(_pool_mx);
+  }
+  for(size_t i = 0; i < _workers.size(); ++i)
+    SDL_WaitThread(_workers[i].thread, NULL);
+  _workers.clear();
+
+  if (_pool_done != NULL)
+    SDL_DestroyCond(_pool_done);
+  if (_pool_wake != NULL)
+    SDL_DestroyCond(_pool_wake);
+  if (_pool_mx != NULL)
+    SDL_DestroyMutex(_pool_mx);
+  _pool_done = _pool_wake = NULL;
+  _pool_mx = NULL;
+}
+
+void particle_emitter::compact()
+{
+  // move last live particle into each dead one, order does not matter
+  size_t i = 0;
+  while (i < _count) {
+    if (_age[i] < _life[i]) {
+      ++i;
+      continue;
+    }
+    size_t last = --_count;
+    _x[i] = _x[last];
+    _y[i] = _y[last];
+    _vx[i] = _vx[last];
+    _vy[i] = _vy[last];
+    _age[i] = _age[last];
+    _life[i] = _life[last];
+  }
+}
+
+void particle_emitter::on_update(screen *)
+{
+  uint32_t ticks = SDL_GetTicks();
+  _dt = _last_ticks != 0 ? (ticks - _last_ticks) / 1000.0f : 0.0f;
+  _last_ticks = ticks;
+  if (_dt <= 0.0f)
+    return;
+
+  // this thread is one of them, pool is restarted if that changed
+  if (_pool_threads != _threads) {
+    stop_workers();
+    if (_threads > 1)
+      start_workers((size_t)_threads - 1);
+    _pool_threads = _threads;
+  }
+
+  size_t jobs = min(_workers.size() + 1, _count / min_job_size);
+  if (jobs <= 1) {
+    simulate(0, _count, _dt);
+  }
+  else {
+    // all workers are woken, idle ones get empty ranges
+    size_t chunk = (_count + jobs - 1) / jobs;
+    SDL_LockMutex(_pool_mx);
+    for(size_t i = 0; i < _workers.size(); ++i) {
+      worker & w = _workers[i];
+      w.from = min((i + 1) * chunk, _count);
+      w.to = min((i + 2) * chunk, _count);
+    }
+    _pool_pending = _workers.size();
+    ++_pool_frame;
+    SDL_CondBroadcast(_pool_wake);
+    SDL_UnlockMutex(_pool_mx);
+
+    // first range is simulated by this thread
+    simulate(0, min(chunk, _count), _dt);
+
+    SDL_LockMutex(_pool_mx);
+    while (_pool_pending > 0)
+      SDL_CondWait(_pool_done, _pool_mx);
+    SDL_UnlockMutex(_pool_mx);
+  }
+  compact();
+
+  if (_active) {
+    _emit_acc += _settings.rate * _dt;
+    size_t n = (size_t)_emit_acc;
+    _emit_acc -= n;
+    burst(n);
+  }
+
+  // particles are not controls, report where they were and are
+  if (GM_GetPartialRedraw()) {
+    rect now = particle_bounds();
+    GM_AddDamage(_bounds);
+    GM_AddDamage(now);
+    _bounds = now;
+  }
+}
+
+rect particle_emitter::particle_bounds() const
+{
+  if (_count == 0)
+    return rect();
+
+  float x0 = _x[0], y0 = _y[0], x1 = _x[0], y1 = _y[0];
+  for(size_t i = 1; i < _count; ++i) {
+    if (_x[i] < x0) x0 = _x[i];
+    else if (_x[i] > x1) x1 = _x[i];
+    if (_y[i] < y0) y0 = _y[i];
+    else if (_y[i] > y1) y1 = _y[i];
+  }
+  // largest particle of the life, one pixel more for rounding
+  float half = max(_settings.size_start, _settings.size_end) / 2 + 1;
+  int l = (int)floorf(x0 - half), t = (int)floorf(y0 - half);
+  int r = (int)ceilf(x1 + half), b = (int)ceilf(y1 + half);
+  return rect(l, t, r - l, b - t);
+}
+
+void particle_emitter::render(SDL_Renderer * r)
+{
+  if (_count == 0)
+    return;
+
+  const color & c0 = _settings.color_start;
+  const color & c1 = _settings.color_end;
+  float size0 = _settings.size_start;
+  float dsize = _settings.size_end - _settings.size_start;
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+  float u0 = 0.0f, v0 = 0.0f, u1 = 1.0f, v1 = 1.0f;
+  if (_sheet != NULL) {
+    float tw = (float)_sheet->base_width();
+    float th = (float)_sheet->base_height();
+    u0 = _clip.x / tw;
+    v0 = _clip.y / th;
+    u1 = (_clip.x + _clip.w) / tw;
+    v1 = (_clip.y + _clip.h) / th;
+  }
+
+  SDL_Vertex * v = &_vertices[0];
+  for(size_t i = 0; i < _count; ++i, v += 4) {
+    float t = _age[i] / _life[i];
+    float half = (size0 + dsize * t) * 0.5f;
+    SDL_Color clr;
+    clr.r = (uint8_t)(c0.r + (c1.r - c0.r) * t);
+    clr.g = (uint8_t)(c0.g + (c1.g - c0.g) * t);
+    clr.b = (uint8_t)(c0.b + (c1.b - c0.b) * t);
+    clr.a = (uint8_t)(c0.a + (c1.a - c0.a) * t);
+
+    v[0].position.x = _x[i] - half; v[0].position.y = _y[i] - half;
+    v[1].position.x = _x[i] + half; v[1].position.y = _y[i] - half;
+    v[2].position.x = _x[i] + half; v[2].position.y = _y[i] + half;
+    v[3].position.x = _x[i] - half; v[3].position.y = _y[i] + half;
+    v[0].tex_coord.x = u0; v[0].tex_coord.y = v0;
+    v[1].tex_coord.x = u1; v[1].tex_coord.y = v0;
+    v[2].tex_coord.x = u1; v[2].tex_coord.y = v1;
+    v[3].tex_coord.x = u0; v[3].tex_coord.y = v1;
+    v[0].color = v[1].color = v[2].color = v[3].color = clr;
+  }
+
+  SDL_Texture * tx = _sheet != NULL ? _sheet->get_texture() : NULL;
+  if (SDL_RenderGeometry(r, tx, &_vertices[0], (int)_count * 4,
+                         &_indices[0], (int)_count * 6) != 0)
+    throw sdl_exception();
+#else
+  // no geometry rendering in this SDL, draw one by one
+  SDL_Texture * tx = _sheet != NULL ? _sheet->get_texture() : NULL;
+  for(size_t i = 0; i < _count; ++i) {
+    float t = _age[i] / _life[i];
+    float size = size0 + dsize * t;
+    color clr((uint8_t)(c0.r + (c1.r - c0.r) * t),
+              (uint8_t)(c0.g + (c1.g - c0.g) * t),
+              (uint8_t)(c0.b + (c1.b - c0.b) * t),
+              (uint8_t)(c0.a + (c1.a - c0.a) * t));
+    rect dst((int)(_x[i] - size / 2), (int)(_y[i] - size / 2), (int)size, (int)size);
+    if (tx != NULL) {
+      SDL_SetTextureColorMod(tx, clr.r, clr.g, clr.b);
+      SDL_SetTextureAlphaMod(tx, clr.a);
+      SDL_RenderCopy(r, tx, &_clip, &dst);
+    }
+    else {
+      clr.apply(r);
+      SDL_RenderFillRect(r, &dst);
+    }
+  }
+  if (tx != NULL) {
+    SDL_SetTextureColorMod(tx, 255, 255, 255);
+    SDL_SetTextureAlphaMod(tx, 255);
+  }
+#endif
+}
@@ -0,0 +1,145 @@
+#include "sdf_font.h"
+#include "util.h"
+#include <math.h>
+
+sdf_face::sdf_face(const std::string & file_path):
+  _fname(file_path),
+  _f(GM_LoadFont(media_path(file_path), base_size)),
+  _height(TTF_FontHeight(_f))
+{
+  build();
+}
+
+sdf_face::sdf_face(const std::string & name, const void * data, size_t size):
+  _fname(name),
+  _f(GM_LoadFontMem(data, size, base_size)),
+  _height(TTF_FontHeight(_f))
+{
+  build();
+}
+
+void sdf_face::build()
+{
+  for(int ch = 0; ch < 256; ++ch) {
+    glyph & g = _glyphs[ch];
+    int minx = 0, maxx = 0, miny = 0, maxy = 0, advance = 0;
+    if (TTF_GlyphMetrics(_f, (Uint16)ch, &minx, &maxx, &miny, &maxy, &advance) != 0)
+      advance = 0;
+    g.advance = advance;
+    g.w = 0;
+    g.h = 0;
+    // control characters are never drawn
+    if (ch < 32)
+      continue;
+
+    SDL_Surface * s = TTF_RenderGlyph_Blended(_f, (Uint16)ch, color::white());
+    if (s == NULL)
+      continue;
+    SDL_Surface * rgba = SDL_ConvertSurfaceFormat(s, SDL_PIXELFORMAT_RGBA8888, 0);
+    SDL_FreeSurface(s);
+    if (rgba == NULL)
+      throw sdl_exception();
+    build_field(g, rgba);
+    SDL_FreeSurface(rgba);
+  }
+  SDL_Log("sdf_face - loaded %s", _fname.c_str());
+}
+
+sdf_face::~sdf_face()
+{
+  if (_f != NULL)
+    TTF_CloseFont(_f);
+}
+
+int sdf_face::kerning(uint8_t prev, uint8_t ch) const
+{
+#if SDL_TTF_VERSION_ATLEAST(2, 0, 14)
+  if (prev != 0 && TTF_GetFontKerning(_f))
+    return TTF_GetFontKerningSizeGlyphs(_f, prev, ch);
+#endif
+  return 0;
+}
+
+void sdf_face::build_field(glyph & g, SDL_Surface * s)
+{
+  g.w = s->w;
+  g.h = s->h;
+  int fw = g.w + 2 * spread;
+  int fh = g.h + 2 * spread;
+
+  // coverage mask with empty border of 'spread' pixels
+  std::vector<uint8_t> inside(fw * fh, 0);
+  for(int y = 0; y < g.h; ++y) {
+    const uint32_t * row = (const uint32_t *)((const uint8_t *)s->pixels + y * s->pitch);
+    for(int x = 0; x < g.w; ++x)
+      inside[(y + spread) * fw + x + spread] = (row[x] & 0xff) >= 128;
+  }
+
+  // distance to the nearest pixel of the other side within spread
+  g.field.resize(fw * fh);
+  const float max_d = (float)spread;
+  for(int y = 0; y < fh; ++y) {
+    for(int x = 0; x < fw; ++x) {
+      uint8_t in = inside[y * fw + x];
+      float best = max_d * max_d;
+      int y0 = max(y - spread, 0), y1 = min(y + spread, fh - 1);
+      int x0 = max(x - spread, 0), x1 = min(x + spread, fw - 1);
+      for(int sy = y0; sy <= y1; ++sy) {
+        for(int sx = x0; sx <= x1; ++sx) {
+          if (inside[sy * fw + sx] == in)
+            continue;
+          float d = (float)((sx - x) * (sx - x) + (sy - y) * (sy - y));
+          if (d < best) best = d;
+        }
+      }
+      // edge lies half way between pixels of different sides
+      float d = sqrtf(best) - 0.5f;
+      if (!in) d = -d;
+      int v = 128 + (int)(d * 127.0f / max_d);
+      g.field[y * fw + x] = (uint8_t)max(0, min(255, v));
+    }
+  }
+}
+
+SDL_Surface * sdf_face::render_glyph(uint8_t ch, float scale, bool blended) const
+{
+  const glyph & g = _glyphs[ch];
+  if (g.w == 0 || g.h == 0 || scale <= 0.0f)
+    return NULL;
+
+  int ow = max((int)(g.w * scale + 0.5f), 1);
+  int oh = max((int)(g.h * scale + 0.5f), 1);
+  SDL_Surface * out = SDL_CreateRGBSurfaceWithFormat(0, ow, oh, 32, SDL_PIXELFORMAT_RGBA8888);
+  if (out == NULL)
+    throw sdl_exception();
+
+  int fw = g.w + 2 * spread;
+  int fh = g.h + 2 * spread;
+  // field value change over one output pixel
+  float ramp = 127.0f / spread / scale;
+
+  for(int y = 0; y < oh; ++y) {
+    uint32_t * row = (uint32_t *)((uint8_t *)out->pixels + y * out->pitch);
+    float fy = (y + 0.5f) / scale - 0.5f + spread;
+    int iy = min(max((int)fy, 0), fh - 2);
+    float ty = min(max(fy - iy, 0.0f), 1.0f);
+    for(int x = 0; x < ow; ++x) {
+      float fx = (x + 0.5f) / scale - 0.5f + spread;
+      int ix = min(max((int)fx, 0), fw - 2);
+      float tx = min(max(fx - ix, 0.0f), 1.0f);
+
+      // bilinear sample of the field
+      const uint8_t * p = &g.field[iy * fw + ix];
+      float top = p[0] + (p[1] - p[0]) * tx;
+      float bottom = p[fw] + (p[fw + 1] - p[fw]) * tx;
+      float v = top + (bottom - top) * ty;
+
+      float a = (v - 128.0f) / ramp + 0.5f;
+      if (!blended)
+        a = a >= 0.5f ? 1.0f : 0.0f;
+      a = min(max(a, 0.0f), 1.0f);
+      row[x] = 0xffffff00 | (uint32_t)(a * 255.0f + 0.5f);
+    }
+  }
+  return out;
+}
@@ -32,27 +32,150 @@ SDL_Texture* GM_CreateTexture(int width, int height, SDL_TextureAccess access, u
   */
 
 sprites_sheet::sprites_sheet(const std::string & file_path, uint32_t sprite_w, uint32_t sprite_h)
-  :texture(GM_LoadSurface(media_path(file_path)), SDL_BLENDMODE_BLEND, true)
+  :texture(GM_LoadSurface(media_path(file_path)), SDL_BLENDMODE_BLEND, true),
+  _atlas(false),
+  _sprite_w(sprite_w),
+  _sprite_h(sprite_h)
 {
   _cols = width() / sprite_w;
   _rows = height() / sprite_h;
+
+  // precompute clip rects row by row
+  _frames.resize(_cols * _rows);
+  for(uint32_t i = 0; i < _frames.size(); ++i) {
+    frame & f = _frames[i];
+    f.clip = rect((i % _cols) * sprite_w, (i / _cols) * sprite_h, sprite_w, sprite_h);
+    f.trimmed = rect(0, 0, sprite_w, sprite_h);
+    f.source_w = sprite_w;
+    f.source_h = sprite_h;
+    f.rotated = false;
+    f.pivot_x = 0.5f;
+    f.pivot_y = 0.5f;
+  }
+}
+
+static json read_atlas(const std::string & atlas_path)
+{
+  json atlas;
+  std::ifstream(media_path(atlas_path)) >> atlas;
+  if (atlas.find("frames") == atlas.end() || atlas.find("meta") == atlas.end()) {
+    SDL_Log("%s - %s is not a sprites atlas",
+      __METHOD_NAME__, atlas_path.c_str());
+    throw std::runtime_error("Invalid sprites atlas file");
+  }
+  return atlas;
+}
+
+static std::string atlas_image_path(const std::string & atlas_path, const json & atlas)
+{
+  path image_path = path(media_path(atlas_path)).parent_path();
+  image_path /= atlas["meta"]["image"].get<std::string>();
+  return image_path.string();
+}
+
+sprites_sheet::sprites_sheet(const std::string & atlas_path)
+  :sprites_sheet(atlas_path, read_atlas(atlas_path))
+{
+}
+
+sprites_sheet::sprites_sheet(const std::string & atlas_path, const json & atlas)
+  :texture(GM_LoadSurface(atlas_image_path(atlas_path, atlas)), SDL_BLENDMODE_BLEND, true),
+  _atlas(true),
+  _cols(0),
+  _rows(1),
+  _sprite_w(0),
+  _sprite_h(0)
+{
+  load_atlas(atlas);
+  SDL_Log("sprites_sheet - loaded %zu frames from %s",
+    _frames.size(), atlas_path.c_str());
 }
 
-rect sprites_sheet::get_sprite_cliprect(size_t idx) const
+static rect atlas_rect(const json & d)
 {
-  rect clip;
-  int row_idx = 0;
-  uint32_t sprite_w = sprite_width();
-  uint32_t sprite_h = sprite_height();
-  while(idx >= _cols) {
-      idx -= _cols;
-      row_idx += 1;
+  return rect(d["x"].get<int>(), d["y"].get<int>(), d["w"].get<int>(), d["h"].get<int>());
+}
+
+static sprites_sheet::frame atlas_frame(const std::string & name, const json & d)
+{
+  sprites_sheet::frame f;
+  f.name = name;
+  f.rotated = d.find("rotated") != d.end() && d["rotated"].get<bool>();
+  f.clip = atlas_rect(d["frame"]);
+  // "frame" size is of the sprite as displayed, the area
+  // on the sheet is transposed for rotated ones
+  if (f.rotated)
+    std::swap(f.clip.w, f.clip.h);
+
+  if (d.find("spriteSourceSize") != d.end())
+    f.trimmed = atlas_rect(d["spriteSourceSize"]);
+  else
+    f.trimmed = rect(0, 0, f.rotated ? f.clip.h : f.clip.w, f.rotated ? f.clip.w : f.clip.h);
+
+  if (d.find("sourceSize") != d.end()) {
+    f.source_w = d["sourceSize"]["w"].get<uint32_t>();
+    f.source_h = d["sourceSize"]["h"].get<uint32_t>();
   }
-  clip.x = idx * sprite_w;
-  clip.y = row_idx * sprite_h;
-  clip.w = sprite_w;
-  clip.h = sprite_h;
-  return clip;
+  else {
+    f.source_w = f.trimmed.x + f.trimmed.w;
+    f.source_h = f.trimmed.y + f.trimmed.h;
+  }
+
+  f.pivot_x = 0.5f;
+  f.pivot_y = 0.5f;
+  if (d.find("pivot") != d.end()) {
+    f.pivot_x = d["pivot"]["x"].get<float>();
+    f.pivot_y = d["pivot"]["y"].get<float>();
+  }
+  return f;
+}
+
+static bool frame_name_less(const sprites_sheet::frame & a, const sprites_sheet::frame & b)
+{
+  return a.name < b.name;
+}
+
+void sprites_sheet::load_atlas(const json & atlas)
+{
+  const json & frames = atlas["frames"];
+  if (frames.is_array()) {
+    for(json::const_iterator it = frames.begin(); it != frames.end(); ++it) {
+      _frames.push_back(atlas_frame((*it)["filename"].get<std::string>(), *it));
+    }
+  }
+  else {
+    for(json::const_iterator it = frames.begin(); it != frames.end(); ++it) {
+      _frames.push_back(atlas_frame(it.key(), it.value()));
+    }
+  }
+  // same frame indices whatever order the atlas lists them in
+  std::sort(_frames.begin(), _frames.end(), frame_name_less);
+
+  for(size_t i = 0; i < _frames.size(); ++i) {
+    const frame & f = _frames[i];
+    if (f.clip.x < 0 || f.clip.y < 0 ||
+        f.clip.x + f.clip.w > base_width() || f.clip.y + f.clip.h > base_height()) {
+      SDL_Log("%s - frame %s is out of sheet bounds",
+        __METHOD_NAME__, f.name.c_str());
+      throw std::runtime_error("Invalid sprites atlas frame");
+    }
+    _names[f.name] = i;
+    _sprite_w = max(_sprite_w, f.source_w);
+    _sprite_h = max(_sprite_h, f.source_h);
+  }
+  // atlas is a single row of frames for index based users
+  _cols = (uint32_t)_frames.size();
+}
+
+size_t sprites_sheet::find_frame(const std::string & name) const
+{
+  std::map<std::string, size_t>::const_iterator it = _names.find(name);
+  if (it == _names.end()) {
+    SDL_Log("%s - frame %s not found",
+      __METHOD_NAME__, name.c_str());
+    throw std::runtime_error("Sprites sheet frame not found");
+  }
+  return it->second;
 }
 
 /*
@@ -80,11 +203,11 @@ sprite::sprite(size_t tex_idx, int px_w, int px_h, sprites_sheet const* sheet)
     _sheet = sheet;
 
     //check sprites sheet
-    if ( _sheet->width() % px_w != 0 || _sheet->height() % px_h != 0 ) {
+    if ( !_sheet->is_atlas() && (_sheet->width() % px_w != 0 || _sheet->height() % px_h != 0) ) {
       SDL_Log("Invalid sprite size=%dx%d for sheet size=%dx%d", px_w, px_h, _sheet->width(), _sheet->height());
       throw std::runtime_error("Invalid sprite size");
     }
-    size_t total_sprites = (_sheet->width() / px_w) * (_sheet->height() / px_h);
+    size_t total_sprites = _sheet->frames_count();
     if (tex_idx >= total_sprites) {
       SDL_Log("Invalid sprite idx=%zu. total sheet length=%zu", tex_idx, total_sprites);
       throw std::runtime_error("Invalid sprite idx");
@@ -92,6 +215,16 @@ sprite::sprite(size_t tex_idx, int px_w, int px_h, sprites_sheet const* sheet)
   }
 }
 
+sprite::sprite(const std::string & frame_name, sprites_sheet const* sheet)
+{
+  idx = sheet->find_frame(frame_name);
+  const sprites_sheet::frame & f = sheet->get_frame(idx);
+  w = f.source_w; h = f.source_h;
+  flip = SDL_FLIP_NONE;
+  angle = 0;
+  _sheet = sheet;
+}
+
 void sprite::render(SDL_Renderer * r, const point & dst_pnt) const
 {
   render(r, rect(), dst_pnt); 
@@ -112,12 +245,49 @@ void sprite::render(SDL_Renderer * r, const rect & dsrc, const rect & dst) const
   if (_sheet == nullptr || _sheet->get_texture() == NULL || w == 0 || h == 0) {
       return;
   }
-  point cnt(w / 2, h / 2);
-  rect src = _sheet->get_sprite_cliprect(idx);
-  src += dsrc.topleft();
-  if (dsrc.w > 0 && dsrc.h > 0) {
-    src.w = dsrc.w;
-    src.h = dsrc.h;
+  const sprites_sheet::frame & f = _sheet->get_frame(idx);
+  bool altered = (dsrc.x != 0 || dsrc.y != 0 || (dsrc.w > 0 && dsrc.h > 0));
+  if (altered || (!f.rotated && f.trimmed.w == (int)f.source_w && f.trimmed.h == (int)f.source_h)) {
+    point cnt((int)(f.pivot_x * dst.w), (int)(f.pivot_y * dst.h));
+    rect src = f.clip;
+    src += dsrc.topleft();
+    if (dsrc.w > 0 && dsrc.h > 0) {
+      src.w = dsrc.w;
+      src.h = dsrc.h;
+    }
+    _sheet->render(r, src, dst, angle, &cnt, flip);
+    return;
+  }
+
+  // place the trimmed area inside of dst scaled to the original size
+  float sx = (float)dst.w / f.source_w;
+  float sy = (float)dst.h / f.source_h;
+  int fx = flip & SDL_FLIP_HORIZONTAL ? f.source_w - f.trimmed.x - f.trimmed.w : f.trimmed.x;
+  int fy = flip & SDL_FLIP_VERTICAL ? f.source_h - f.trimmed.y - f.trimmed.h : f.trimmed.y;
+  float tx = dst.x + fx * sx, ty = dst.y + fy * sy;
+  float tw = f.trimmed.w * sx, th = f.trimmed.h * sy;
+  float px = dst.x + f.pivot_x * dst.w, py = dst.y + f.pivot_y * dst.h;
+
+  if (!f.rotated) {
+    rect to((int)tx, (int)ty, (int)tw, (int)th);
+    point cnt((int)(px - to.x), (int)(py - to.y));
+    _sheet->render(r, f.clip, to, angle, &cnt, flip);
+    return;
   }
-  _sheet->render(r, src, dst, angle, &cnt, flip);
+
+  // rotated frames are turned back by -90 degrees around the
+  // trimmed area center, which combined with sprite's own angle
+  // around the pivot is a single rotation around the pivot of
+  // a shifted rect
+  float cx = tx + tw / 2, cy = ty + th / 2;
+  float dx = (px - cx) + (py - cy);
+  float dy = (py - cy) - (px - cx);
+  rect to((int)(cx + dx - th / 2), (int)(cy + dy - tw / 2), (int)th, (int)tw);
+  point cnt((int)(px - to.x), (int)(py - to.y));
+
+  // flips are applied before rotation, so axes are swapped
+  int rflip = SDL_FLIP_NONE;
+  if (flip & SDL_FLIP_HORIZONTAL) rflip |= SDL_FLIP_VERTICAL;
+  if (flip & SDL_FLIP_VERTICAL) rflip |= SDL_FLIP_HORIZONTAL;
+  _sheet->render(r, f.clip, to, angle - 90, &cnt, (SDL_RendererFlip)rflip);
 }
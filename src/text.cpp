@@ -23,10 +23,12 @@ text_input::text_input(const rect & pos,
   enable_hightlight_on_focus();
   kbd_up += boost::bind(&text_input::on_kbd_up, this, _1);
   focused += boost::bind(&text_input::on_focused, this, _1);
+  mouse_down += boost::bind(&text_input::on_mouse_down, this, _1);
 
-  set_font(ui::manager::instance()->get_font("input"));
-  set_idle_color(ui::manager::instance()->get_idle_color("input"));
-  set_highlight_color(ui::manager::instance()->get_highlight_color("input"));
+  const theme_style & style = ui::manager::instance()->get_style("input");
+  set_font(style.get_font());
+  set_idle_color(style.get_idle_color());
+  set_highlight_color(style.get_highlight_color());
 }
 
 
@@ -181,7 +183,11 @@ void text_input::blink_cursor()
     a = 255 + i_elapsed;
   else
     a = i_elapsed;
-  _cursor_alpha = int32_to_uint8(a);
+  uint8_t cursor_alpha = int32_to_uint8(a);
+  if (cursor_alpha != _cursor_alpha) {
+    _cursor_alpha = cursor_alpha;
+    invalidate();
+  }
 }
 
 void text_input::set_cursor(size_t c)
@@ -190,35 +196,19 @@ void text_input::set_cursor(size_t c)
     c = get_text().length();
 
   _cursor = c;
+  invalidate();
 }
 
 void text_input::erase_at(size_t c)
 {
-  const std::string & txt = get_text();
-  std::stringstream ss;
-  std::string before = txt.substr(0, c);
-  ss << before;
-  int chars_left = txt.length() - c - 1;
-  if (chars_left > 0) {
-    std::string after = txt.substr(c + 1, int32_to_uint32(chars_left));
-    ss << after;
-  }
-  set_text(ss.str());
-  if (_cursor > txt.length())
-    _cursor = txt.length();
-  mark_dirty();
+  erase_text(c, 1);
+  if (_cursor > get_text().length())
+    _cursor = get_text().length();
 }
 
 void text_input::insert_at(size_t c, const std::string & val)
 {
-  const std::string & txt = get_text();
-  std::string before = txt.substr(0, c);
-  std::string after = txt.substr(c, txt.length() - c);
-  std::stringstream ss;
-  ss << before;
-  ss << val;
-  ss << after;
-  set_text(ss.str());
+  insert_text(c, val);
 }
 
 // render text & cursor
@@ -240,15 +230,22 @@ void text_input::draw(SDL_Renderer * r, const rect & dst)
     color clr(get_hightlight_color());
     clr.a = _cursor_alpha;
     clr.apply(r);
-    SDL_RenderDrawLine(r, cur.x, cur.y, cur.x, cur.y + get_text_texture().height());
+    SDL_RenderDrawLine(r, cur.x, cur.y, cur.x, cur.y + get_text_rect().h);
   }
 }
 
 point text_input::get_cursor_pos(const rect & dst)
 {
-  std::string sub = get_text().substr(0, _cursor);
-  rect txt_rect = get_font()->get_text_rect(sub);
-  return point (get_text_offset().x + txt_rect.w, get_text_offset().y);
+  return point (get_text_offset().x + get_text_widths().x_at(_cursor), get_text_offset().y);
+}
+
+void text_input::on_mouse_down(control * target)
+{
+  if (_readonly)
+    return;
+  // place cursor at the char boundary closest to the pointer
+  int x = manager::instance()->get_pointer().x - get_absolute_pos().x - get_text_offset().x;
+  set_cursor(get_text_widths().index_at(x));
 }
 
 } //namespace ui
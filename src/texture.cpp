@@ -1,6 +1,10 @@
 #include "texture.h"
 #include "multi_texture.h"
 
+#include <zlib.h>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
 /* Texture */
 
 texture::texture():
@@ -296,6 +300,22 @@ void texture::render(SDL_Renderer* r, const rect & src, const rect & dst,
     throw sdl_exception();
 }
 
+void texture::render_polygon(SDL_Renderer* r, const std::vector<point> & pts,
+                             const point & offset) const
+{
+  if (_texture == NULL || pts.size() < 3) {
+    return;
+  }
+  std::vector<int> vx(pts.size()), vy(pts.size());
+  for(size_t i = 0; i < pts.size(); ++i) {
+    vx[i] = pts[i].x;
+    vy[i] = pts[i].y;
+  }
+  if (SDLEx_RenderFillTexturedPolygon(r, &vx[0], &vy[0], (int)pts.size(),
+                                      _texture, offset.x, offset.y) != 0)
+    throw sdl_exception();
+}
+
 void texture::set_color_mod(const color & rgb)
 {
   set_color_mod(rgb.r, rgb.g, rgb.b);
@@ -355,21 +375,24 @@ uint8_t texture::get_alpha()
 
 multi_texture::multi_texture(const rect & size):
   _width(size.w), 
-  _height(size.h)
+  _height(size.h),
+  _lod_levels(0)
 {
   init();
 }
 
 multi_texture::multi_texture(const rect & size, int fw, int fh):
   _width(size.w), 
-  _height(size.h)
+  _height(size.h),
+  _lod_levels(0)
 {
   init(fw, fh);
 }
 
 multi_texture::multi_texture(int w, int h, int fw, int fh):
   _width(w),
-  _height(h)
+  _height(h),
+  _lod_levels(0)
 {
   init(fw, fh);
 }
@@ -387,6 +410,119 @@ multi_texture::fragment::fragment(rect & pos):
           rand_color.tostr().c_str());
 }
 
+multi_texture::fragment::~fragment()
+{
+  set_lod_levels(0);
+}
+
+void multi_texture::fragment::set_lod_levels(int levels)
+{
+  std::vector<texture*>::iterator it = _levels.begin();
+  for(; it != _levels.end(); ++it) {
+    delete *it;
+  }
+  _levels.clear();
+
+  for(int lvl = 1; lvl <= levels; ++lvl) {
+    int lw = (_pos.w + (1 << lvl) - 1) >> lvl;
+    int lh = (_pos.h + (1 << lvl) - 1) >> lvl;
+    // no point to go below a single pixel
+    if (lw <= 1 && lh <= 1)
+      break;
+    _levels.push_back(new texture(lw, lh, SDL_TEXTUREACCESS_TARGET));
+  }
+  _dirty = rect(0, 0, _pos.w, _pos.h);
+}
+
+texture & multi_texture::fragment::get_level(int level)
+{
+  if (level <= 0 || _levels.empty())
+    return _tx;
+  if (level > (int)_levels.size())
+    level = (int)_levels.size();
+  return *_levels[level - 1];
+}
+
+void multi_texture::fragment::invalidate(const rect & area)
+{
+  if (_levels.empty())
+    return;
+  rect clipped;
+  rect bounds(0, 0, _pos.w, _pos.h);
+  if (SDL_IntersectRect(&bounds, &area, &clipped) != SDL_TRUE)
+    return;
+  if (_dirty.w == 0 || _dirty.h == 0)
+    _dirty = clipped;
+  else
+    SDL_UnionRect(&_dirty, &clipped, &_dirty);
+}
+
+void multi_texture::fragment::update_levels(SDL_Renderer * r)
+{
+  if (_levels.empty() || _dirty.w == 0 || _dirty.h == 0)
+    return;
+
+  // dirty edges in the coordinates of the previous level,
+  // rounded outwards so partial pixels are re-sampled too
+  int x0 = _dirty.x, y0 = _dirty.y;
+  int x1 = _dirty.x + _dirty.w, y1 = _dirty.y + _dirty.h;
+
+  texture * prev = &_tx;
+  std::vector<texture*>::iterator it = _levels.begin();
+  for(; it != _levels.end(); ++it) {
+    texture * lvl = *it;
+    x0 = x0 >> 1;
+    y0 = y0 >> 1;
+    x1 = min((x1 + 1) >> 1, lvl->width());
+    y1 = min((y1 + 1) >> 1, lvl->height());
+
+    rect dst(x0, y0, x1 - x0, y1 - y0);
+    rect src(dst.x * 2, dst.y * 2, dst.w * 2, dst.h * 2);
+    // last row/column of an odd sized level
+    if (src.x + src.w > prev->width()) src.w = prev->width() - src.x;
+    if (src.y + src.h > prev->height()) src.h = prev->height() - src.y;
+
+    // overwrite the area instead of blending over stale pixels
+    SDL_BlendMode bmode = prev->get_blend_mode();
+    prev->set_blend_mode(SDL_BLENDMODE_NONE);
+#if SDL_VERSION_ATLEAST(2, 0, 12)
+    SDL_SetTextureScaleMode(prev->get_texture(), SDL_ScaleModeLinear);
+#endif
+    {
+      // rendered in the middle of a frame, not presented
+      texture::render_context ctx(lvl, r, false);
+      prev->render(r, src, dst);
+    }
+    prev->set_blend_mode(bmode);
+    prev = lvl;
+  }
+  _dirty = rect();
+}
+
+void multi_texture::set_lod_levels(int levels)
+{
+  lock_container(_fragments);
+  _lod_levels = max(levels, 0);
+  container<fragment*>::iterator it = _fragments.begin();
+  for(; it != _fragments.end(); ++it) {
+    (*it)->set_lod_levels(_lod_levels);
+  }
+}
+
+int multi_texture::select_level(const rect & src, const rect & dst) const
+{
+  int level = 0;
+  if (_lod_levels == 0 || dst.w <= 0 || dst.h <= 0)
+    return level;
+  // use the smallest level still not smaller than 'dst'
+  float factor = min((float)src.w / dst.w, (float)src.h / dst.h);
+  while (level < _lod_levels && factor >= 2.0f) {
+    factor /= 2.0f;
+    ++level;
+  }
+  return level;
+}
+
 void multi_texture::init(int fw, int fh)
 {
   uint32_t fragments_w = 0;
@@ -444,30 +580,45 @@ void multi_texture::init(int fw, int fh)
 
 void multi_texture::render(SDL_Renderer * r, const rect & src, const rect & dst)
 {
+  if (src.w <= 0 || src.h <= 0)
+    return;
+  // empty destination size means no scaling
+  rect to(dst.x, dst.y,
+          dst.w > 0 ? dst.w : src.w,
+          dst.h > 0 ? dst.h : src.h);
+  int level = select_level(src, to);
+
   lock_container(_fragments);
   container<fragment*>::iterator it = _fragments.begin();
   for(; it != _fragments.end(); ++it) {
     fragment * f = *it;
     if (!f->pos().collide_rect(src))
       continue;
-    rect fragment_src = f->pos().clip(src) - f->pos().topleft();
-    rect fragment_dst(dst.x, dst.y,
-                      fragment_src.w,
-                      fragment_src.h);
-    if (f->pos().x > 0)
-      fragment_dst.x += f->pos().x - src.x;
-    if (f->pos().y > 0)
-      fragment_dst.y += f->pos().y - src.y;
-
-//    SDL_Log("***");
-//    SDL_Log("frg_src=%s", fragment_src.tostr().c_str());
-//    SDL_Log("frg_dst=%s", fragment_dst.tostr().c_str());
-//    SDL_Log("frg_pos=%s", f->pos().tostr().c_str());
-//    SDL_Log("src=%s", src.tostr().c_str());
-//    SDL_Log("dst=%s", dst.tostr().c_str());
-    f->get_texture().render(r,
-                            fragment_src,
-                            fragment_dst);
+    rect clipped = f->pos().clip(src);
+
+    // destination edges are computed from absolute source edges
+    // so neighbour fragments meet without gaps when scaled
+    int dx0 = to.x + (int)((int64_t)(clipped.x - src.x) * to.w / src.w);
+    int dy0 = to.y + (int)((int64_t)(clipped.y - src.y) * to.h / src.h);
+    int dx1 = to.x + (int)((int64_t)(clipped.x + clipped.w - src.x) * to.w / src.w);
+    int dy1 = to.y + (int)((int64_t)(clipped.y + clipped.h - src.y) * to.h / src.h);
+    if (dx1 <= dx0 || dy1 <= dy0)
+      continue;
+
+    rect fragment_src = clipped - f->pos().topleft();
+    if (level > 0) {
+      f->update_levels(r);
+      int lvl = min(level, f->lod_levels());
+      texture & tx = f->get_level(lvl);
+      int x0 = fragment_src.x >> lvl;
+      int y0 = fragment_src.y >> lvl;
+      int x1 = min((fragment_src.x + fragment_src.w + (1 << lvl) - 1) >> lvl, tx.width());
+      int y1 = min((fragment_src.y + fragment_src.h + (1 << lvl) - 1) >> lvl, tx.height());
+      tx.render(r, rect(x0, y0, x1 - x0, y1 - y0), rect(dx0, dy0, dx1 - dx0, dy1 - dy0));
+    }
+    else {
+      f->get_texture().render(r, fragment_src, rect(dx0, dy0, dx1 - dx0, dy1 - dy0));
+    }
   }
 }
 
@@ -500,6 +651,7 @@ void multi_texture::render_sprite(SDL_Renderer * r, const sprite & s, const poin
         texture::render_context ctx(&f->get_texture(), r);
         s.sheet()->render(r, src + s.get_clip_rect().topleft(), dst);
       }
+      f->invalidate(clipped - fpos.topleft());
     }
   }
 }
@@ -522,6 +674,7 @@ void multi_texture::render_texture(SDL_Renderer * r, const texture & tx, const p
         texture::render_context ctx(&f->get_texture(), r);
         tx.render(r, src, dst);
       }
+      f->invalidate(clipped - fpos.topleft());
     }
   }
 }
@@ -554,6 +707,7 @@ void multi_texture::render_draw_lines(SDL_Renderer * r,
       SDL_RenderDrawLines(r, adj, count);
       delete[] adj;
     }
+    f->invalidate(bounds - fpos.topleft());
   }
 }
 
@@ -568,10 +722,11 @@ void multi_texture::render_draw_rect(SDL_Renderer * r, const rect & rct)
       rect clipped = rct.clip(fpos);
       // render into the fragment's texture with clipped rect
       {
-        rect dst(clipped.x - fpos.x, clipped.y - rct.y, clipped.w, clipped.h);
+        rect dst(clipped.x - fpos.x, clipped.y - fpos.y, clipped.w, clipped.h);
         texture::render_context ctx(&f->get_texture(), r);
         SDL_RenderDrawRect(r, &dst);
       }
+      f->invalidate(clipped - fpos.topleft());
     }
   }
 }
@@ -587,10 +742,11 @@ void multi_texture::render_fill_rect(SDL_Renderer * r, const rect & rct)
       rect clipped = rct.clip(fpos);
       // render into the fragment's texture with clipped rect
       {
-        rect dst(clipped.x - fpos.x, clipped.y - rct.y, clipped.w, clipped.h);
+        rect dst(clipped.x - fpos.x, clipped.y - fpos.y, clipped.w, clipped.h);
         texture::render_context ctx(&f->get_texture(), r);
         SDL_RenderFillRect(r, &dst);
       }
+      f->invalidate(clipped - fpos.topleft());
     }
   }
 }
@@ -601,11 +757,239 @@ void multi_texture::render_clear(SDL_Renderer * r)
   container<fragment*>::iterator it = _fragments.begin();
   for(; it != _fragments.end(); ++it) {
     fragment * f = *it;
-    texture::render_context ctx(&f->get_texture(), r);
-    SDL_RenderClear(r);
+    {
+      texture::render_context ctx(&f->get_texture(), r);
+      SDL_RenderClear(r);
+    }
+    f->invalidate(rect(0, 0, f->pos().w, f->pos().h));
+  }
+}
+
+/*
+ * multi_texture cache file layout (native byte order):
+ *
+ *   cache_header
+ *   cache_tile[tiles]
+ *   pixel blocks, each starts at a 16 bytes aligned offset
+ *
+ * Raw blocks hold tile's RGBA pixels with pitch = w * 4 and are
+ * uploaded straight from the file mapping, compressed blocks are
+ * zlib streams of the same data.
+ */
+
+static const uint32_t cache_magic = 0x43544d47; // "GMTC"
+static const uint32_t cache_version = 1;
+
+enum cache_block_type {
+  cache_block_raw = 0,
+  cache_block_zlib = 1
+};
+
+struct cache_header {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t content_hash;
+  int32_t width;
+  int32_t height;
+  uint32_t pixel_format;
+  uint32_t tiles;
+};
+
+struct cache_tile {
+  int32_t x, y, w, h;
+  uint32_t block_type;
+  uint32_t reserved;
+  uint64_t offset;
+  uint64_t size;
+};
+
+uint64_t multi_texture::hash_content(const void * data, size_t len, uint64_t seed)
+{
+  const uint8_t * p = (const uint8_t *)data;
+  uint64_t h = seed;
+  for(size_t i = 0; i < len; ++i) {
+    h ^= p[i];
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+bool multi_texture::load_cache(SDL_Renderer * r, const std::string & file_path, uint64_t content_hash)
+{
+  if (!exists(file_path))
+    return false;
+
+  namespace ipc = boost::interprocess;
+  ipc::file_mapping file;
+  ipc::mapped_region region;
+  try {
+    file = ipc::file_mapping(file_path.c_str(), ipc::read_only);
+    region = ipc::mapped_region(file, ipc::read_only);
+  }
+  catch (const ipc::interprocess_exception & ex) {
+    SDL_Log("%s - failed to map %s: %s",
+      __METHOD_NAME__, file_path.c_str(), ex.what());
+    return false;
+  }
+
+  const uint8_t * base = (const uint8_t *)region.get_address();
+  size_t file_size = region.get_size();
+  if (file_size < sizeof(cache_header))
+    return false;
+
+  const cache_header * hdr = (const cache_header *)base;
+  if (hdr->magic != cache_magic || hdr->version != cache_version ||
+      hdr->content_hash != content_hash ||
+      hdr->width != _width || hdr->height != _height) {
+#ifdef GM_DEBUG
+    SDL_Log("%s - cache %s is stale", __METHOD_NAME__, file_path.c_str());
+#endif
+    return false;
+  }
+
+  lock_container(_fragments);
+  if (hdr->tiles != _fragments.size() ||
+      file_size < sizeof(cache_header) + hdr->tiles * sizeof(cache_tile)) {
+    return false;
+  }
+
+  // verify the whole index before touching any fragment
+  const cache_tile * tiles = (const cache_tile *)(base + sizeof(cache_header));
+  for(uint32_t i = 0; i < hdr->tiles; ++i) {
+    const cache_tile & t = tiles[i];
+    const rect & fpos = _fragments[i]->pos();
+    // block must lie within the file, checked without overflow
+    if (t.x != fpos.x || t.y != fpos.y || t.w != fpos.w || t.h != fpos.h ||
+        t.size > file_size || t.offset > file_size - t.size ||
+        (t.block_type != cache_block_raw && t.block_type != cache_block_zlib) ||
+        (t.block_type == cache_block_raw && t.size != (uint64_t)t.w * t.h * 4)) {
+      SDL_Log("%s - cache %s has invalid tile %u",
+        __METHOD_NAME__, file_path.c_str(), i);
+      return false;
+    }
+  }
+
+  std::vector<uint8_t> unpacked;
+  for(uint32_t i = 0; i < hdr->tiles; ++i) {
+    const cache_tile & t = tiles[i];
+    fragment * f = _fragments[i];
+    const void * pixels = base + t.offset;
+
+    if (t.block_type == cache_block_zlib) {
+      uLongf len = (uLongf)t.w * t.h * 4;
+      unpacked.resize(len);
+      if (uncompress(&unpacked[0], &len, base + t.offset, (uLong)t.size) != Z_OK ||
+          len != unpacked.size()) {
+        SDL_Log("%s - cache %s has corrupted tile %u",
+          __METHOD_NAME__, file_path.c_str(), i);
+        return false;
+      }
+      pixels = &unpacked[0];
+    }
+
+    if (SDL_UpdateTexture(f->get_texture().get_texture(), NULL, pixels, t.w * 4) != 0)
+      throw sdl_exception();
+    f->invalidate(rect(0, 0, t.w, t.h));
+  }
+#ifdef GM_DEBUG
+  SDL_Log("%s - loaded %u tiles from %s",
+    __METHOD_NAME__, hdr->tiles, file_path.c_str());
+#endif
+  return true;
+}
+
+void multi_texture::save_cache(SDL_Renderer * r, const std::string & file_path, uint64_t content_hash,
+                               bool compressed)
+{
+  lock_container(_fragments);
+  std::string tmp_path = file_path + ".tmp";
+  std::ofstream out(tmp_path.c_str(), std::ios::binary | std::ios::trunc);
+  if (!out) {
+    SDL_Log("%s - failed to open %s for writing",
+      __METHOD_NAME__, tmp_path.c_str());
+    throw std::runtime_error("Failed to write multi_texture cache");
   }
+
+  cache_header hdr;
+  hdr.magic = cache_magic;
+  hdr.version = cache_version;
+  hdr.content_hash = content_hash;
+  hdr.width = _width;
+  hdr.height = _height;
+  hdr.pixel_format = SDL_PIXELFORMAT_RGBA8888;
+  hdr.tiles = (uint32_t)_fragments.size();
+
+  // index is written again when block offsets are known
+  std::vector<cache_tile> tiles(hdr.tiles);
+  out.write((const char *)&hdr, sizeof(hdr));
+  out.write((const char *)&tiles[0], tiles.size() * sizeof(cache_tile));
+
+  std::vector<uint8_t> pixels;
+  std::vector<uint8_t> packed;
+  uint64_t offset = sizeof(hdr) + tiles.size() * sizeof(cache_tile);
+  for(uint32_t i = 0; i < hdr.tiles; ++i) {
+    fragment * f = _fragments[i];
+    const rect & fpos = f->pos();
+    cache_tile & t = tiles[i];
+    t.x = fpos.x; t.y = fpos.y; t.w = fpos.w; t.h = fpos.h;
+    t.reserved = 0;
+
+    pixels.resize((size_t)fpos.w * fpos.h * 4);
+    {
+      texture::render_context ctx(&f->get_texture(), r);
+      if (SDL_RenderReadPixels(r, NULL, hdr.pixel_format, &pixels[0], fpos.w * 4) != 0)
+        throw sdl_exception();
+    }
+
+    const uint8_t * block = &pixels[0];
+    uLongf block_size = (uLongf)pixels.size();
+    t.block_type = cache_block_raw;
+    if (compressed) {
+      uLongf len = compressBound((uLong)pixels.size());
+      packed.resize(len);
+      if (compress2(&packed[0], &len, &pixels[0], (uLong)pixels.size(), Z_BEST_SPEED) == Z_OK &&
+          len < pixels.size()) {
+        block = &packed[0];
+        block_size = len;
+        t.block_type = cache_block_zlib;
+      }
+    }
+
+    // keep raw blocks aligned for direct upload from the mapping
+    static const char zeros[16] = { 0 };
+    size_t pad = (size_t)((16 - offset % 16) % 16);
+    out.write(zeros, pad);
+    offset += pad;
+
+    t.offset = offset;
+    t.size = block_size;
+    out.write((const char *)block, block_size);
+    offset += block_size;
+  }
+
+  out.seekp(sizeof(hdr));
+  out.write((const char *)&tiles[0], tiles.size() * sizeof(cache_tile));
+  out.close();
+  if (!out) {
+    SDL_Log("%s - failed to write %s",
+      __METHOD_NAME__, tmp_path.c_str());
+    throw std::runtime_error("Failed to write multi_texture cache");
+  }
+
+  // replace previous cache only when the new one is complete
+  rename(tmp_path, file_path);
+#ifdef GM_DEBUG
+  SDL_Log("%s - saved %u tiles to %s, %llu bytes",
+    __METHOD_NAME__, hdr.tiles, file_path.c_str(), (unsigned long long)offset);
+#endif
 }
 
 multi_texture::~multi_texture()
 {
+  lock_container(_fragments);
+  container<fragment*>::iterator it = _fragments.begin();
+  for(; it != _fragments.end(); ++it) {
+    delete *it;
+  }
+  _fragments.clear();
 }
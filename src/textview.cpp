@@ -0,0 +1,381 @@
+#include "textview.h"
+
+namespace ui {
+
+text_view::text_view(const rect & pos, const padding & pad):
+  control(pos),
+  _pad(pad),
+  _style(get_type_name()),
+  _font(nullptr),
+  _font_style(font_style::solid),
+  _lines(0),
+  _max_lines(0),
+  _rows(0),
+  _wrap_w(-1),
+  _scroll_row(0),
+  _follow(true)
+{
+  set_style(_style);
+  mouse_wheel += boost::bind(&text_view::on_wheel, this, _1);
+}
+
+text_view::~text_view()
+{
+}
+
+void text_view::set_style(const std::string & st)
+{
+  _style = st;
+  const theme_style & style = ui::manager::instance()->get_style(_style);
+  _font_style = style.get_font_style();
+  _color_idle = style.get_idle_color();
+  _color_back = style.get_back_color();
+  set_font(style.get_font());
+}
+
+void text_view::set_font(const base_font * fnt)
+{
+  _font = fnt;
+  // all chunks are stale now
+  std::deque<chunk>::iterator it = _chunks.begin();
+  for(; it != _chunks.end(); ++it)
+    it->wrap_w = -1;
+  _wrap_w = -1;
+  _rows = 0;
+  invalidate();
+}
+
+int text_view::visible_rows() const
+{
+  if (_font == nullptr || _font->line_height() <= 0)
+    return 0;
+  return max(_pos.h - _pad.top - _pad.bottom, 0) / _font->line_height();
+}
+
+void text_view::wrap(paragraph & p) const
+{
+  p.breaks.clear();
+  if (_font == nullptr || _wrap_w <= 0)
+    return;
+
+  const std::string & t = p.text;
+  size_t row = 0;
+  size_t space = std::string::npos;
+  int x = 0;
+  uint8_t prev = 0;
+  for(size_t i = 0; i < t.length(); ++i) {
+    uint8_t ch = (uint8_t)t[i];
+    int w = _font->kerning(prev, ch) + _font->glyph_advance(ch);
+    if (x + w > _wrap_w && i > row) {
+      // break after the last space of the row, or inside a long word
+      size_t br = (space != std::string::npos && space >= row) ? space + 1 : i;
+      p.breaks.push_back((uint32_t)br);
+      row = br;
+      space = std::string::npos;
+      // measure what moved to the new row
+      x = 0;
+      prev = 0;
+      for(size_t j = br; j < i; ++j) {
+        uint8_t c = (uint8_t)t[j];
+        x += _font->kerning(prev, c) + _font->glyph_advance(c);
+        prev = c;
+      }
+      w = _font->kerning(prev, ch) + _font->glyph_advance(ch);
+    }
+    if (ch == ' ')
+      space = i;
+    x += w;
+    prev = ch;
+  }
+}
+
+void text_view::wrap_chunk(chunk & c)
+{
+  c.rows = 0;
+  std::vector<paragraph>::iterator it = c.lines.begin();
+  for(; it != c.lines.end(); ++it) {
+    wrap(*it);
+    c.rows += it->rows();
+  }
+  c.wrap_w = _wrap_w;
+  _rows += c.rows;
+}
+
+void text_view::wrap_stale()
+{
+  int w = _pos.w - _pad.left - _pad.right;
+  if (w != _wrap_w) {
+    // resized or font changed, every paragraph wraps again
+    _wrap_w = w;
+    _rows = 0;
+  }
+  std::deque<chunk>::iterator it = _chunks.begin();
+  for(; it != _chunks.end(); ++it) {
+    if (it->wrap_w != _wrap_w)
+      wrap_chunk(*it);
+  }
+}
+
+size_t text_view::rows_count()
+{
+  wrap_stale();
+  return _rows;
+}
+
+size_t text_view::max_scroll_row()
+{
+  size_t rows = rows_count();
+  size_t visible = (size_t)visible_rows();
+  return rows > visible ? rows - visible : 0;
+}
+
+text_view::chunk & text_view::locate(size_t idx, size_t & in_chunk)
+{
+  // only the first chunk can be partially trimmed, others are full
+  size_t first = _chunks.front().lines.size();
+  if (idx < first) {
+    in_chunk = idx;
+    return _chunks.front();
+  }
+  idx -= first;
+  in_chunk = idx % chunk_lines;
+  return _chunks[1 + idx / chunk_lines];
+}
+
+void text_view::append(const std::string & txt)
+{
+  size_t from = 0;
+  for(;;) {
+    size_t eol = txt.find('\n', from);
+    size_t to = (eol == std::string::npos) ? txt.length() : eol;
+
+    if (_chunks.empty() || _chunks.back().lines.size() >= chunk_lines) {
+      _chunks.push_back(chunk());
+      _chunks.back().lines.reserve(chunk_lines);
+      _chunks.back().rows = 0;
+      _chunks.back().wrap_w = _wrap_w;
+    }
+    chunk & c = _chunks.back();
+    c.lines.push_back(paragraph());
+    paragraph & p = c.lines.back();
+    p.text.assign(txt, from, to - from);
+    // stale chunks are wrapped as a whole later
+    if (c.wrap_w == _wrap_w) {
+      wrap(p);
+      c.rows += p.rows();
+      _rows += p.rows();
+    }
+    ++_lines;
+
+    // text ending with a new line adds no empty paragraph
+    if (eol == std::string::npos || eol + 1 == txt.length())
+      break;
+    from = eol + 1;
+  }
+  trim();
+  invalidate();
+}
+
+void text_view::set_line(size_t idx, const std::string & txt)
+{
+  if (idx >= _lines) {
+    SDL_Log("%s - line %zu is out of range of %zu lines",
+      __METHOD_NAME__, idx, _lines);
+    throw std::out_of_range("text_view line index is out of range");
+  }
+  size_t i = 0;
+  chunk & c = locate(idx, i);
+  paragraph & p = c.lines[i];
+  p.text = txt;
+  if (c.wrap_w == _wrap_w) {
+    size_t old_rows = p.rows();
+    wrap(p);
+    c.rows = c.rows - old_rows + p.rows();
+    _rows = _rows - old_rows + p.rows();
+  }
+  invalidate();
+}
+
+const std::string & text_view::get_line(size_t idx) const
+{
+  if (idx >= _lines) {
+    SDL_Log("%s - line %zu is out of range of %zu lines",
+      __METHOD_NAME__, idx, _lines);
+    throw std::out_of_range("text_view line index is out of range");
+  }
+  size_t first = _chunks.front().lines.size();
+  if (idx < first)
+    return _chunks.front().lines[idx].text;
+  idx -= first;
+  return _chunks[1 + idx / chunk_lines].lines[idx % chunk_lines].text;
+}
+
+void text_view::clear()
+{
+  _chunks.clear();
+  _lines = 0;
+  _rows = 0;
+  _scroll_row = 0;
+  _follow = true;
+  invalidate();
+}
+
+void text_view::set_max_lines(size_t n)
+{
+  _max_lines = n;
+  trim();
+}
+
+void text_view::trim()
+{
+  if (_max_lines == 0 || _lines <= _max_lines)
+    return;
+
+  size_t removed_rows = 0;
+  while (_lines > _max_lines) {
+    chunk & c = _chunks.front();
+    size_t n = min(_lines - _max_lines, c.lines.size());
+    size_t rows = 0;
+    if (c.wrap_w == _wrap_w) {
+      for(size_t i = 0; i < n; ++i)
+        rows += c.lines[i].rows();
+    }
+    if (n == c.lines.size()) {
+      _chunks.pop_front();
+    }
+    else {
+      c.lines.erase(c.lines.begin(), c.lines.begin() + n);
+      c.rows -= rows;
+    }
+    _lines -= n;
+    _rows -= rows;
+    removed_rows += rows;
+  }
+  // keep the same text in view while reading the history
+  if (!_follow)
+    _scroll_row -= min(removed_rows, _scroll_row);
+  invalidate();
+}
+
+void text_view::scroll_to(size_t row)
+{
+  size_t last = max_scroll_row();
+  _scroll_row = min(row, last);
+  _follow = (_scroll_row == last);
+  invalidate();
+}
+
+void text_view::scroll_by(int rows)
+{
+  if (rows < 0 && (size_t)-rows > _scroll_row)
+    scroll_to(0);
+  else
+    scroll_to(_scroll_row + rows);
+}
+
+void text_view::scroll_to_end()
+{
+  _scroll_row = max_scroll_row();
+  _follow = true;
+  invalidate();
+}
+
+void text_view::on_wheel(control * target)
+{
+  const SDL_Event * sdl_ev = ui::manager::current_event();
+  scroll_by(-sdl_ev->wheel.y * 3);
+}
+
+void text_view::load(const json & d)
+{
+  if (d.find("font") != d.end() && d["font"].is_array()) {
+    set_font(manager::load_font(d["font"].at(0), d["font"].at(1)));
+    if (d.find("font_style") != d.end())
+      _font_style = manager::font_style_from_str(d["font_style"]);
+  }
+
+  if (d.find("color_back") != d.end())
+    _color_back = color::from_json(d["color_back"]);
+
+  if (d.find("color_idle") != d.end())
+    _color_idle = color::from_json(d["color_idle"]);
+
+  if (d.find("padding") != d.end()) {
+    if (d["padding"].is_array()) {
+      _pad = padding(
+          d["padding"].at(0),
+          d["padding"].at(1),
+          d["padding"].at(2),
+          d["padding"].at(3));
+    }
+    if (d["padding"].is_number())
+      _pad = padding(d["padding"].get<int>());
+  }
+
+  if (d.find("max_lines") != d.end() && d["max_lines"].is_number())
+    set_max_lines(d["max_lines"].get<size_t>());
+
+  if (d.find("lines") != d.end() && d["lines"].is_array()) {
+    json::const_iterator it = d["lines"].begin();
+    for(; it != d["lines"].end(); ++it)
+      append(it->get<std::string>());
+  }
+
+  control::load(d);
+}
+
+void text_view::draw(SDL_Renderer * r, const rect & dst)
+{
+  if (_color_back.a > 0) {
+    _color_back.apply(r);
+    SDL_RenderFillRect(r, &dst);
+  }
+
+  if (_font != nullptr && _lines > 0) {
+    wrap_stale();
+    if (_follow)
+      _scroll_row = max_scroll_row();
+    else
+      _scroll_row = min(_scroll_row, max_scroll_row());
+
+    int lh = _font->line_height();
+    int x = dst.x + _pad.left;
+    int y = dst.y + _pad.top;
+    int bottom = dst.y + dst.h - _pad.bottom;
+    bool blended = (_font_style == font_style::blended);
+
+    texture::clip_context clip(r, dst);
+
+    // skip whole chunks above the view
+    size_t row = _scroll_row;
+    std::deque<chunk>::iterator c = _chunks.begin();
+    while (c != _chunks.end() && row >= c->rows) {
+      row -= c->rows;
+      ++c;
+    }
+
+    for(; c != _chunks.end() && y < bottom; ++c) {
+      std::vector<paragraph>::const_iterator p = c->lines.begin();
+      for(; p != c->lines.end() && y < bottom; ++p) {
+        size_t rows = p->rows();
+        if (row >= rows) {
+          row -= rows;
+          continue;
+        }
+        for(; row < rows && y < bottom; ++row, y += lh) {
+          size_t from = row == 0 ? 0 : p->breaks[row - 1];
+          size_t to = row < p->breaks.size() ? p->breaks[row] : p->text.length();
+          if (to <= from)
+            continue;
+          _row.assign(p->text, from, to - from);
+          _font->render_text(r, _row, point(x, y), _color_idle, blended);
+        }
+        row = 0;
+      }
+    }
+  }
+
+  control::draw(r, dst);
+}
+
+} //namespace ui
@@ -1,12 +1,15 @@
 #include "manager.h"
 #include "dialog.h"
 #include "util.h"
+#include "font_registry.h"
 
 #include "box.h"
 #include "label.h"
 #include "button.h"
 #include "text.h"
 #include "combo.h"
+#include "textview.h"
+#include "listview.h"
 
 /** User Idle Counter **/
 
@@ -18,21 +21,16 @@ uint32_t UI_GetUserIdle()
 
 namespace ui {
 
-/** Fonts cache */
+/** Fonts */
 
-typedef std::map<std::string, ttf_font*> fonts_cache;
-static fonts_cache g_fonts_cache;
+base_font* manager::load_font(const std::string & font_file, const size_t & ptsize)
+{
+  return font_registry::instance()->load(font_file, ptsize);
+}
 
-ttf_font* manager::load_font(const std::string & font_file, const size_t & ptsize)
+base_font* manager::load_sdf_font(const std::string & font_file, const size_t & ptsize)
 {
-  std::string font_id = (std::stringstream() << font_file << ":" << ptsize).str();
-  fonts_cache::iterator i = g_fonts_cache.find(font_id);
-  if (i == g_fonts_cache.end()) {
-    ttf_font * font = new ttf_font(font_file, ptsize);
-    g_fonts_cache.insert(std::make_pair(font_id, font));
-    return font;
-  }
-  return i->second;
+  return font_registry::instance()->load(font_file, ptsize, true);
 }
 
 font_style manager::font_style_from_str(const std::string & s)
@@ -81,12 +79,20 @@ manager::manager(rect & available_rect,
   screen::component(NULL),
   _hovered_cnt(NULL),
   _focused_cnt(NULL),
-  _cur_event(NULL)
+  _cur_event(NULL),
+  _hit_cols(0),
+  _hit_rows(0),
+  _hit_gen(0)
 {
   set_pos(available_rect);
+  // root of the identifier index
+  index_tree(this);
   // read theme settings
   std::ifstream(media_path(theme_file)) >> _theme_data;
   _theme_sprites.load(_theme_data["res"]);
+  // open theme fonts now rather than on first control creation
+  font_registry::instance()->preload(_theme_data);
+  compile_theme();
 }
 
 void manager::destroy(control* child)
@@ -126,35 +132,135 @@ json manager::get_theme_prop(const std::string & type_name, const std::string &
   }
 }
 
+/** Theme Styles **/
+theme_style::theme_style():
+  _resolved(0),
+  _font(NULL),
+  _font_style(font_style::solid)
+{
+}
+
+void theme_style::require(int prop, const char * name) const
+{
+  if (_resolved & prop)
+    return;
+  SDL_Log("ui::theme_style - failed to find any property '%s'", name);
+  throw std::runtime_error("failed to find theme property");
+}
+
+const base_font * theme_style::get_font() const
+{
+  require(has_font, "font");
+  return _font;
+}
+
+font_style theme_style::get_font_style() const
+{
+  require(has_font_style, "font_style");
+  return _font_style;
+}
+
+const color & theme_style::get_idle_color() const
+{
+  require(has_idle_color, "idle_color");
+  return _idle;
+}
+
+const color & theme_style::get_highlight_color() const
+{
+  require(has_highlight_color, "highlight_color");
+  return _highlight;
+}
+
+const color & theme_style::get_back_color() const
+{
+  require(has_back_color, "back_color");
+  return _back;
+}
+
+void manager::compile_style(const json & d, theme_style & s)
+{
+  if (d.find("font") != d.end()) {
+    const json & font = d.at("font");
+    if (font.is_array()) {
+      // optional third item selects distance field rendering
+      if (font.size() > 2 && font.at(2) == "sdf")
+        s._font = load_sdf_font(font.at(0), font.at(1));
+      else
+        s._font = load_font(font.at(0), font.at(1));
+      s._resolved |= theme_style::has_font;
+    }
+    else {
+      // not a font, the root one is not used either
+      SDL_Log("ui::manager::compile_style - font is not an array");
+      s._font = NULL;
+      s._resolved &= ~theme_style::has_font;
+    }
+  }
+  if (d.find("font_style") != d.end()) {
+    s._font_style = font_style_from_str(d.at("font_style"));
+    s._resolved |= theme_style::has_font_style;
+  }
+  if (d.find("idle_color") != d.end()) {
+    s._idle = color::from_json(d.at("idle_color"));
+    s._resolved |= theme_style::has_idle_color;
+  }
+  if (d.find("highlight_color") != d.end()) {
+    s._highlight = color::from_json(d.at("highlight_color"));
+    s._resolved |= theme_style::has_highlight_color;
+  }
+  if (d.find("back_color") != d.end()) {
+    s._back = color::from_json(d.at("back_color"));
+    s._resolved |= theme_style::has_back_color;
+  }
+}
+
+void manager::compile_theme()
+{
+  _styles.clear();
+  _root_style = theme_style();
+  compile_style(_theme_data, _root_style);
+  json::const_iterator it = _theme_data.begin();
+  for(; it != _theme_data.end(); ++it) {
+    if (!it.value().is_object())
+      continue;
+    theme_style s = _root_style;
+    compile_style(it.value(), s);
+    _styles[it.key()] = s;
+  }
+}
+
+const theme_style & manager::get_style(const std::string & type_name) const
+{
+  std::unordered_map<std::string, theme_style>::const_iterator it = _styles.find(type_name);
+  if (it != _styles.end())
+    return it->second;
+  return _root_style;
+}
+
 color manager::get_back_color(const std::string & type_name)
 {
-  return color::from_json(get_theme_prop(type_name, "back_color"));
+  return get_style(type_name).get_back_color();
 }
 
 color manager::get_highlight_color(const std::string & type_name)
 {
-  return color::from_json(get_theme_prop(type_name, "highlight_color"));
+  return get_style(type_name).get_highlight_color();
 }
 
 color manager::get_idle_color(const std::string & type_name)
 {
-  return color::from_json(get_theme_prop(type_name, "idle_color"));
+  return get_style(type_name).get_idle_color();
 }
 
 font_style manager::get_font_style(const std::string &type_name)
 {
-  return manager::font_style_from_str(get_theme_prop(type_name, "font_style"));
+  return get_style(type_name).get_font_style();
 }
 
-const ttf_font * manager::get_font(const std::string & type_name)
+const base_font * manager::get_font(const std::string & type_name)
 {
-  json font = get_theme_prop(type_name, "font");
-  if (font.is_array()) {
-    return load_font(font.at(0), font.at(1));
-  }
-  SDL_Log("ui::manager::get_font - failed to load font for %s",
-          type_name.c_str());
-  throw std::runtime_error("failed to load font");
+  return get_style(type_name).get_font();
 }
 
 void manager::set_focused_control(control * target)
@@ -192,6 +298,8 @@ void manager::set_hovered_control(control * target)
 
 void manager::render(SDL_Renderer* r)
 {
+  // changes made by event handlers
+  box::layout_pending();
   // call UI protocol's render
   control::draw(r, get_absolute_pos());
 }
@@ -224,6 +332,9 @@ void manager::on_update(screen *)
     g_graveyard.clear();
   }
 
+  // one layout pass of the changed boxes
+  box::layout_pending();
+
   // call UI protocol's update
   control::update();
 }
@@ -233,6 +344,9 @@ void manager::on_event(SDL_Event* ev)
   mutex_lock lock(_cur_event_mx);
   _cur_event = ev;
 
+  // hit-testing needs the current layout
+  box::layout_pending();
+
   // reset user idle timer
   if (ev->type == SDL_MOUSEMOTION || ev->type == SDL_MOUSEWHEEL ||
       ev->type == SDL_MOUSEBUTTONDOWN || ev->type == SDL_MOUSEBUTTONUP ||
@@ -254,7 +368,7 @@ void manager::on_event(SDL_Event* ev)
     {
       // update hovered control if pointer was moved before callback
       // reset found to NULL if actual control is hidden or proxy
-      control * found = find_child_at(ev->motion.x, ev->motion.y);
+      control * found = hit_test(point(ev->motion.x, ev->motion.y));
       if (found != NULL && !found->visible()) {
         found = NULL;
       }
@@ -290,13 +404,80 @@ void manager::on_event(SDL_Event* ev)
   // had changed state of other controls (hidden/deleted)
   {
     point pointer = manager::instance()->get_pointer();
-    control * found = find_child_at(pointer);
+    control * found = hit_test(pointer);
     // reset found to NULL if actual control is hidden or proxy
     if (found != NULL && !found->visible() ) found = NULL;
     set_hovered_control(found);
   }
 }
 
+void manager::index_children(const control * parent)
+{
+  const control_list & children = parent->children();
+  control_list::const_iterator it = children.begin();
+  for(; it != children.end(); ++it) {
+    control * child = *it;
+    if (child->destroyed() || !child->visible())
+      continue;
+    // children are clipped to the visible rect of the parent
+    rect area = child->get_visible_rect();
+    if (area.w <= 0 || area.h <= 0)
+      continue;
+
+    uint32_t idx = (uint32_t)_hit_entries.size();
+    hit_entry e = { child, area };
+    _hit_entries.push_back(e);
+
+    int col0 = max((area.x - _hit_area.x) / hit_cell_size, 0);
+    int row0 = max((area.y - _hit_area.y) / hit_cell_size, 0);
+    int col1 = min((area.x + area.w - 1 - _hit_area.x) / hit_cell_size, _hit_cols - 1);
+    int row1 = min((area.y + area.h - 1 - _hit_area.y) / hit_cell_size, _hit_rows - 1);
+    for(int row = row0; row <= row1; ++row)
+      for(int col = col0; col <= col1; ++col)
+        _hit_cells[row * _hit_cols + col].push_back(idx);
+
+    index_children(child);
+  }
+}
+
+void manager::rebuild_hit_index()
+{
+  _hit_area = get_visible_rect();
+  _hit_cols = max((_hit_area.w + hit_cell_size - 1) / hit_cell_size, 1);
+  _hit_rows = max((_hit_area.h + hit_cell_size - 1) / hit_cell_size, 1);
+
+  // keep allocated cells between rebuilds
+  size_t cells = (size_t)_hit_cols * _hit_rows;
+  if (_hit_cells.size() < cells)
+    _hit_cells.resize(cells);
+  for(size_t i = 0; i < _hit_cells.size(); ++i)
+    _hit_cells[i].clear();
+  _hit_entries.clear();
+
+  index_children(this);
+  _hit_gen = layout_generation();
+}
+
+control * manager::hit_test(const point & at)
+{
+  if (_hit_gen != layout_generation())
+    rebuild_hit_index();
+  if (!_hit_area.collide_point(at))
+    return NULL;
+
+  int col = (at.x - _hit_area.x) / hit_cell_size;
+  int row = (at.y - _hit_area.y) / hit_cell_size;
+  const std::vector<uint32_t> & cell = _hit_cells[row * _hit_cols + col];
+  // the last drawn control is the top one, like in find_child_at
+  std::vector<uint32_t>::const_reverse_iterator it = cell.rbegin();
+  for(; it != cell.rend(); ++it) {
+    const hit_entry & e = _hit_entries[*it];
+    if (e.area.collide_point(at))
+      return e.cnt;
+  }
+  return NULL;
+}
+
 /*
  * Construct controls from JSON description
  */
@@ -319,6 +500,20 @@ control* create_control(const std::string type_id, rect & pos)
   {
     return new panel(pos);
   }
+  if (type_id.find("text_view") != std::string::npos)
+  {
+    // styled text view
+    text_view* view = new text_view(pos);
+    view->set_style(type_id);
+    return view;
+  }
+  if (type_id.find("list_view") != std::string::npos)
+  {
+    // styled list view, the source is set by the application
+    list_view* view = new list_view(pos);
+    view->set_style(type_id);
+    return view;
+  }
   if (type_id.find("label") != std::string::npos)
   {
     // styled label
@@ -350,17 +545,96 @@ control* create_control(const std::string type_id, rect & pos)
   return NULL;
 }
 
+/** Identifier Index **/
+
+typedef std::unordered_multimap<std::string, control*> id_index;
+static id_index g_id_index;
+
+void manager::index_tree(control * c)
+{
+  if (!c->_indexed) {
+    g_id_index.insert(id_index::value_type(c->_id, c));
+    c->_indexed = true;
+  }
+  control_list::iterator it = c->_children.begin();
+  for(; it != c->_children.end(); ++it)
+    index_tree(*it);
+}
+
+void manager::unindex(control * c)
+{
+  if (!c->_indexed)
+    return;
+  std::pair<id_index::iterator, id_index::iterator> range = g_id_index.equal_range(c->_id);
+  for(id_index::iterator it = range.first; it != range.second; ++it) {
+    if (it->second == c) {
+      g_id_index.erase(it);
+      break;
+    }
+  }
+  c->_indexed = false;
+}
+
+void manager::unindex_tree(control * c)
+{
+  unindex(c);
+  control_list::iterator it = c->_children.begin();
+  for(; it != c->_children.end(); ++it)
+    unindex_tree(*it);
+}
+
+void manager::rename_indexed(control * c, const std::string & id)
+{
+  unindex(c);
+  c->_id = id;
+  g_id_index.insert(id_index::value_type(c->_id, c));
+  c->_indexed = true;
+}
+
+control * manager::find_indexed(control * root, const std::string & id)
+{
+  control * found = NULL;
+  std::pair<id_index::iterator, id_index::iterator> range = g_id_index.equal_range(id);
+  for(id_index::iterator it = range.first; it != range.second; ++it) {
+    control * c = it->second;
+    if (c->destroyed())
+      continue;
+    // parents of indexed controls are indexed as well,
+    // so the chain leads to the manager
+    control * p = c;
+    while (p != NULL && p != root)
+      p = p->_parent;
+    if (p == NULL)
+      continue;
+    // depth-first order decides between several
+    if (found != NULL)
+      return root->search_child(id);
+    found = c;
+  }
+  return found;
+}
+
 control * control::find_child(const std::string & id)
 {
   // check self
   if (_id == id) return this;
+  // detached controls are not indexed
+  if (!_indexed)
+    return search_child(id);
+  return manager::find_indexed(this, id);
+}
+
+control * control::search_child(const std::string & id)
+{
+  // check self, destroyed controls are skipped as by the index
+  if (_id == id && !_destroyed) return this;
   // check children
   control_list::iterator it = _children.begin();
   for(; it != _children.end(); ++it) {
     control * child = *it;
-    if (child->identifier() == id)
+    if (child->identifier() == id && !child->destroyed())
       return child;
-    child = child->find_child(id);
+    child = child->search_child(id);
     if (child)
       return child;
   }
@@ -376,6 +650,7 @@ void manager::pop_front(control * c)
   control * tmp = _children[last];
   _children[last] = c;
   _children[idx] = tmp;
+  layout_changed();
 }
 
 void manager::push_back(control * c)
@@ -385,6 +660,7 @@ void manager::push_back(control * c)
   control * tmp = _children[0];
   _children[0] = c;
   _children[idx] = tmp;
+  layout_changed();
 }
 
 control* manager::build(const json & d)
@@ -433,10 +709,16 @@ control* manager::build(const json & d)
 
   // process children
   if (d.find("children") != d.end()) {
+    // boxes are laid out once for all of the children
+    box * b = dynamic_cast<box*>(inst);
+    if (b != NULL)
+      b->begin_update();
     json::const_iterator child = d["children"].begin();
     for(; child != d["children"].end(); ++child) {
       inst->add_child(build(*child));
     }
+    if (b != NULL)
+      b->end_update();
   }
 
   return inst;